@@ -0,0 +1,932 @@
+#include "safeconfig.h"
+#include "safeconfig_batch.h"
+#include "safeconfig_frozen.h"
+#include "safeconfig_layers.h"
+#include "safeconfig_nlohmann.h"
+#include "safeconfig_snapshot.h"
+#include "safeconfig_writer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace safeconfig;
+using Json = nlohmann::json;
+
+// Counts heap allocations made by the whole process, through every replaceable form of `operator new` (e.g.
+// `std::pmr::new_delete_resource` uses the aligned one); reported per iteration by `AllocationCounter`
+static std::atomic<std::size_t> allocationCount{ 0 };
+
+static void* countedAllocate(std::size_t size) noexcept
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+static void* countedAllocate(std::size_t size, std::align_val_t alignment) noexcept
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+  // `std::aligned_alloc` requires a size that is a multiple of the alignment
+  auto align = static_cast<std::size_t>(alignment);
+  return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void* operator new(std::size_t size)
+{
+  if (void* ptr = countedAllocate(size))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return countedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  if (void* ptr = countedAllocate(size, alignment))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return countedAllocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return countedAllocate(size, alignment);
+}
+
+// Both `countedAllocate` overloads allocate memory that `std::free` releases
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
+
+// Reports the allocations made while alive as an "allocs/op" counter of `state`
+class AllocationCounter
+{
+public:
+  explicit AllocationCounter(benchmark::State& state)
+    : _state(state)
+    , _start(allocationCount.load(std::memory_order_relaxed))
+  {}
+
+  ~AllocationCounter()
+  {
+    auto count = static_cast<double>(allocationCount.load(std::memory_order_relaxed) - _start);
+    _state.counters["allocs/op"] = benchmark::Counter(count, benchmark::Counter::kAvgIterations);
+  }
+
+private:
+  benchmark::State& _state;
+  std::size_t _start;
+};
+
+static std::vector<std::string> makeStringChoices(std::size_t count)
+{
+  std::vector<std::string> choices;
+  choices.reserve(count);
+
+  for (std::size_t i = 0; i < count; ++i)
+    choices.push_back("choice-" + std::to_string(i));
+
+  return choices;
+}
+
+static std::vector<int> makeIntegerChoices(std::size_t count, int stride)
+{
+  std::vector<int> choices;
+  choices.reserve(count);
+
+  for (std::size_t i = 0; i < count; ++i)
+    choices.push_back(static_cast<int>(i) * stride);
+
+  return choices;
+}
+
+// A group with one property of each value type; its properties are allocated from `resource`
+class SyntheticGroup : public Group
+{
+public:
+  SyntheticGroup(std::string_view name, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    : Group(name)
+    , _count(allocateUnique<NumericProperty>(resource, "count", std::pair<int, int>{ 0, 1000 }, resource))
+    , _ratio(allocateUnique<NumericProperty>(resource, "ratio", std::pair<double, double>{ 0.0, 1.0 }, resource))
+    , _mode(allocateUnique<ChoiceProperty>(resource, "mode", modeConstraint(), resource))
+  {
+    _mode->setValue<std::string>("safe");
+  }
+
+  void operator<<(const JsonLike& json) override
+  {
+    _count->setValue<int>(json.at(_count->getName()));
+    _ratio->setValue<double>(json.at(_ratio->getName()));
+    _mode->setValue<std::string>(json.at(_mode->getName()));
+  }
+
+  void operator>>(JsonLike& json) const override
+  {
+    json[_count->getName()] = _count->getValue<int>();
+    json[_ratio->getName()] = _ratio->getValue<double>();
+    json[_mode->getName()] = _mode->getValue<std::string>();
+  }
+
+protected:
+  void visitProperties(const std::function<void(Property&)>& visitor) override
+  {
+    visitor(*_count);
+    visitor(*_ratio);
+    visitor(*_mode);
+  }
+
+  void visitProperties(const std::function<void(const Property&)>& visitor) const override
+  {
+    visitor(*_count);
+    visitor(*_ratio);
+    visitor(*_mode);
+  }
+
+private:
+  static const std::shared_ptr<const ChoiceConstraint>& modeConstraint()
+  {
+    static const auto constraint = std::make_shared<const ChoiceConstraint>(std::vector<std::string>{ "fast", "safe", "off" });
+    return constraint;
+  }
+
+  ResourcePtr<Property> _count;
+  ResourcePtr<Property> _ratio;
+  ResourcePtr<Property> _mode;
+};
+
+static std::string groupName(std::size_t index)
+{
+  return "group" + std::to_string(index);
+}
+
+static std::unique_ptr<Configuration> makeConfiguration(std::size_t groupCount)
+{
+  auto configuration = std::make_unique<Configuration>("config");
+
+  for (std::size_t i = 0; i < groupCount; ++i)
+    configuration->insert(std::make_shared<SyntheticGroup>(groupName(i)));
+
+  return configuration;
+}
+
+static Json makeJson(std::size_t groupCount)
+{
+  Json json;
+
+  for (std::size_t i = 0; i < groupCount; ++i)
+  {
+    Json& groupJson = json["config"][groupName(i)];
+    groupJson["count"] = static_cast<int>(i % 1000);
+    groupJson["ratio"] = 0.5;
+    groupJson["mode"] = "fast";
+  }
+
+  return json;
+}
+
+// Building and tearing down configurations
+
+static void BM_ConfigurationBuild(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    Configuration configuration("config");
+
+    for (std::size_t i = 0; i < groupCount; ++i)
+      configuration.emplace<SyntheticGroup>(groupName(i));
+
+    benchmark::DoNotOptimize(configuration);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationBuild)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationBuildInArena(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  std::pmr::monotonic_buffer_resource arena;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    {
+      Configuration configuration("config", &arena);
+
+      for (std::size_t i = 0; i < groupCount; ++i)
+        configuration.emplace<SyntheticGroup>(groupName(i));
+
+      benchmark::DoNotOptimize(configuration);
+    }
+
+    arena.release();
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationBuildInArena)->RangeMultiplier(8)->Range(1, 4096);
+
+// Property
+
+static void BM_PropertyGetValueInteger(benchmark::State& state)
+{
+  NumericProperty property("property", std::pair<int, int>{ 0, 100 });
+  property.setValue(42);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(property.getValue<int>());
+}
+BENCHMARK(BM_PropertyGetValueInteger);
+
+static void BM_PropertyGetValueReal(benchmark::State& state)
+{
+  NumericProperty property("property", std::pair<double, double>{ 0.0, 1.0 });
+  property.setValue(0.5);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(property.getValue<double>());
+}
+BENCHMARK(BM_PropertyGetValueReal);
+
+static void BM_PropertyGetValueString(benchmark::State& state)
+{
+  ChoiceProperty property("property", makeStringChoices(8));
+  property.setValue<std::string>("choice-3");
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(property.getValue<std::string>());
+}
+BENCHMARK(BM_PropertyGetValueString);
+
+static void BM_TypedPropertyGetValueInteger(benchmark::State& state)
+{
+  TypedNumericProperty<int> property("property", { 0, 100 });
+  property.setValue(42);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(property.getValue());
+}
+BENCHMARK(BM_TypedPropertyGetValueInteger);
+
+static void BM_TypedPropertySetValueInteger(benchmark::State& state)
+{
+  TypedNumericProperty<int> property("property", { 0, 100 });
+  int value = 0;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    property.setValue(value);
+    value = (value + 1) % 100;
+  }
+}
+BENCHMARK(BM_TypedPropertySetValueInteger);
+
+static void BM_PropertySetValueInteger(benchmark::State& state)
+{
+  NumericProperty property("property", std::pair<int, int>{ 0, 100 });
+  int value = 0;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    property.setValue(value);
+    value = (value + 1) % 100;
+  }
+}
+BENCHMARK(BM_PropertySetValueInteger);
+
+static void BM_PropertySetValueReal(benchmark::State& state)
+{
+  NumericProperty property("property", std::pair<double, double>{ 0.0, 1.0 });
+  double value = 0.0;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    property.setValue(value);
+    value = value < 0.9 ? value + 0.1 : 0.0;
+  }
+}
+BENCHMARK(BM_PropertySetValueReal);
+
+static void BM_PropertySetValueString(benchmark::State& state)
+{
+  auto choices = makeStringChoices(8);
+  ChoiceProperty property("property", choices);
+  std::size_t index = 0;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    property.setValue(choices[index]);
+    index = (index + 1) % choices.size();
+  }
+}
+BENCHMARK(BM_PropertySetValueString);
+
+// ChoiceConstraint
+
+static void BM_ChoiceConstraintIsValidString(benchmark::State& state)
+{
+  auto count = static_cast<std::size_t>(state.range(0));
+  auto choices = makeStringChoices(count);
+  ChoiceConstraint constraint(choices);
+
+  // Alternate hits and misses
+  std::vector<ValueModel> values;
+  values.push_back(StringValueModel(choices[count / 2]));
+  values.push_back(StringValueModel("choice-missing"));
+  std::size_t index = 0;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(constraint.isValid(values[index]));
+    index ^= 1;
+  }
+}
+BENCHMARK(BM_ChoiceConstraintIsValidString)->RangeMultiplier(4)->Range(4, 10000);
+
+static void BM_ChoiceConstraintIsValidInteger(benchmark::State& state)
+{
+  auto count = static_cast<std::size_t>(state.range(0));
+  auto stride = static_cast<int>(state.range(1));
+  auto choices = makeIntegerChoices(count, stride);
+  ChoiceConstraint constraint(choices);
+
+  std::vector<ValueModel> values;
+  values.push_back(IntegerValueModel(choices[count / 2]));
+  values.push_back(IntegerValueModel(-1));
+  std::size_t index = 0;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(constraint.isValid(values[index]));
+    index ^= 1;
+  }
+}
+// Stride 1 gives dense choices, stride 1000 gives sparse ones
+BENCHMARK(BM_ChoiceConstraintIsValidInteger)->ArgsProduct({ benchmark::CreateRange(4, 10000, 4), { 1, 1000 } });
+
+// Bulk numeric validation, against checking each value through its constraint
+
+static void BM_NumericConstraintIsValidEach(benchmark::State& state)
+{
+  auto count = static_cast<std::size_t>(state.range(0));
+  std::vector<std::unique_ptr<Constraint>> constraints;
+  std::vector<ValueModel> values;
+
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    auto bound = static_cast<int>(i);
+    constraints.push_back(std::make_unique<NumericConstraint>(bound, bound + 100));
+    values.push_back(IntegerValueModel(bound + static_cast<int>(i % 128)));
+  }
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    std::size_t failures = 0;
+
+    for (std::size_t i = 0; i < count; ++i)
+      failures += !constraints[i]->isValid(values[i]);
+
+    benchmark::DoNotOptimize(failures);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NumericConstraintIsValidEach)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+static void BM_NumericBatchValidate(benchmark::State& state)
+{
+  auto count = static_cast<std::size_t>(state.range(0));
+  NumericBatch batch;
+
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    auto bound = static_cast<int>(i);
+    batch.add("value", bound + static_cast<int>(i % 128), bound, bound + 100);
+  }
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(batch.validate());
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NumericBatchValidate)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+// Configuration
+
+static void BM_ConfigurationGet(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  std::string name = groupName(groupCount / 2);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(configuration->get(name));
+}
+BENCHMARK(BM_ConfigurationGet)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationGetTyped(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  std::string name = groupName(groupCount / 2);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(configuration->getTyped<SyntheticGroup>(name));
+}
+BENCHMARK(BM_ConfigurationGetTyped)->RangeMultiplier(8)->Range(1, 4096);
+
+// Concurrent reads of a published snapshot
+
+static const AtomicConfiguration<>& sharedAtomicConfiguration()
+{
+  static AtomicConfiguration<> source;
+  static std::once_flag published;
+
+  std::call_once(published, [] { source.publish(makeConfiguration(64)); });
+
+  return source;
+}
+
+// Through a reader per thread, as a hot path reading a string value without a cache would
+static void BM_AtomicConfigurationReaderGetString(benchmark::State& state)
+{
+  AtomicConfiguration<>::Reader reader(sharedAtomicConfiguration());
+
+  for (auto _ : state)
+  {
+    std::string mode = reader->get("group32")->findProperty("mode")->getValue<std::string>();
+    benchmark::DoNotOptimize(mode);
+  }
+}
+BENCHMARK(BM_AtomicConfigurationReaderGetString)->Threads(1)->Threads(4);
+
+static void BM_CachedPropertyGetString(benchmark::State& state)
+{
+  static CachedProperty<std::string> mode(sharedAtomicConfiguration(), "group32", "mode");
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(&mode.get());
+}
+BENCHMARK(BM_CachedPropertyGetString)->Threads(1)->Threads(4);
+
+// Json round-trips through the nlohmann adapter
+
+static void BM_ConfigurationLoad(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    *configuration << NLohmannJsonWrapper(json);
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationLoad)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationLoadCompiled(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  CompiledBinding binding(*configuration);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    binding.load(NLohmannJsonWrapper(json));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationLoadCompiled)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationLoadTransaction(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  Transaction transaction(*configuration);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    transaction.load(NLohmannJsonWrapper(json)).commit();
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationLoadTransaction)->RangeMultiplier(8)->Range(1, 4096);
+
+// Loads lazily, then accesses a single group, as a deployment using few of its subsystems would
+static void BM_ConfigurationLoadLazy(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  auto jsonWrapper = std::make_shared<NLohmannJsonWrapper>(json);
+  std::string name = groupName(groupCount / 2);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    configuration->loadLazy(jsonWrapper);
+    benchmark::DoNotOptimize(configuration->get(name));
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationLoadLazy)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationLoadParallel(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto threadCount = static_cast<unsigned>(state.range(1));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+
+  for (auto _ : state)
+    configuration->loadParallel(NLohmannJsonWrapper(json), threadCount);
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationLoadParallel)->ArgsProduct({ { 64, 4096 }, { 1, 4 } })->UseRealTime();
+
+static void BM_ConfigurationLoadSnapshot(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  *configuration << NLohmannJsonWrapper(json);
+
+  std::stringstream stream;
+  writeSnapshot(*configuration, stream);
+  std::string data = stream.str();
+  SnapshotView snapshot(data.data(), data.size());
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    loadSnapshot(*configuration, snapshot);
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationLoadSnapshot)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationUpdateUnchanged(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  *configuration << NLohmannJsonWrapper(json);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(configuration->update(NLohmannJsonWrapper(json)));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationUpdateUnchanged)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationStreamingLoad(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  std::string text = makeJson(groupCount).dump();
+  StreamingLoader loader(*configuration);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    loader.load(text);
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationStreamingLoad)->RangeMultiplier(8)->Range(1, 4096);
+
+// Overrides a single group on top of a full defaults layer, by merging documents and reloading everything
+static void BM_ConfigurationLoadMergedOverride(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json defaults = makeJson(groupCount);
+  Json overrides;
+  overrides["config"][groupName(0)]["count"] = 7;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    Json merged = defaults;
+    merged.merge_patch(overrides);
+    *configuration << NLohmannJsonWrapper(merged);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationLoadMergedOverride)->RangeMultiplier(8)->Range(1, 4096);
+
+// As above, by setting the override layer of `ConfigurationLayers`
+static void BM_ConfigurationLayersSetOverride(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json defaults = makeJson(groupCount);
+  Json overrides;
+  overrides["config"][groupName(0)]["count"] = 7;
+
+  ConfigurationLayers layers(*configuration);
+  layers.addLayer("defaults", std::make_shared<NLohmannJsonWrapper>(defaults));
+  std::size_t overridesLayer = layers.addLayer("overrides");
+  auto overridesJson = std::make_shared<NLohmannJsonWrapper>(overrides);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    layers.setLayer(overridesLayer, overridesJson);
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationLayersSetOverride)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationStore(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  *configuration << NLohmannJsonWrapper(json);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    Json output;
+    *configuration >> NLohmannJsonWrapper(output);
+    benchmark::DoNotOptimize(output);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationStore)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationRoundTrip(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    *configuration << NLohmannJsonWrapper(json);
+
+    Json output;
+    *configuration >> NLohmannJsonWrapper(output);
+    benchmark::DoNotOptimize(output);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationRoundTrip)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_ConfigurationStoreText(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  *configuration << NLohmannJsonWrapper(json);
+  std::string output;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    output.clear();
+    *configuration >> JsonTextWriter(output);
+    benchmark::DoNotOptimize(output.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationStoreText)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_FrozenConfigurationStoreText(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  *configuration << NLohmannJsonWrapper(json);
+  FrozenConfiguration frozen(*configuration);
+  std::string output;
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+  {
+    output.clear();
+    JsonTextWriter writer(output);
+    frozen.write(writer);
+    writer.finish();
+    benchmark::DoNotOptimize(output.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FrozenConfigurationStoreText)->RangeMultiplier(8)->Range(1, 4096);
+
+// Full-configuration scans
+
+static void BM_ConfigurationValidate(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  *configuration << NLohmannJsonWrapper(json);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(configuration->validate());
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigurationValidate)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_FrozenConfigurationValidate(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  *configuration << NLohmannJsonWrapper(json);
+  FrozenConfiguration frozen(*configuration);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(frozen.validate());
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FrozenConfigurationValidate)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_FrozenConfigurationDiff(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+  Json json = makeJson(groupCount);
+  *configuration << NLohmannJsonWrapper(json);
+  FrozenConfiguration before(*configuration);
+  json["config"][groupName(0)]["mode"] = "off";
+  *configuration << NLohmannJsonWrapper(json);
+  FrozenConfiguration after(*configuration);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(before.diff(after));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FrozenConfigurationDiff)->RangeMultiplier(8)->Range(1, 4096);
+
+static void BM_FrozenConfigurationFreeze(benchmark::State& state)
+{
+  auto groupCount = static_cast<std::size_t>(state.range(0));
+  auto configuration = makeConfiguration(groupCount);
+
+  AllocationCounter counter(state);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(FrozenConfiguration(*configuration));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FrozenConfigurationFreeze)->RangeMultiplier(8)->Range(1, 4096);
+
+BENCHMARK_MAIN();
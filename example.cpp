@@ -1,12 +1,149 @@
 
 #include "safeconfig.h"
-#include "nlohmann_json.h"
+#include "safeconfig_batch.h"
+#include "safeconfig_frozen.h"
+#include "safeconfig_instrumentation.h"
+#include "safeconfig_layers.h"
+#include "safeconfig_nlohmann.h"
+#include "safeconfig_snapshot.h"
+#include "safeconfig_writer.h"
 
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <sstream>
+#include <thread>
 #include <utility>
 
+// Counts allocations from the global heap, for checking that groups built in an arena make none
+static std::atomic<std::size_t> globalAllocationCount{ 0 };
+
+static void* countedAllocate(std::size_t size) noexcept
+{
+  ++globalAllocationCount;
+  return std::malloc(size ? size : 1);
+}
+
+static void* countedAllocate(std::size_t size, std::align_val_t alignment) noexcept
+{
+  ++globalAllocationCount;
+
+  auto align = static_cast<std::size_t>(alignment);
+  return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+// Every replaceable form, so that all of them are counted and none is released by a mismatched `operator delete`
+void* operator new(std::size_t size)
+{
+  if (void* address = countedAllocate(size))
+    return address;
+
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return countedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  if (void* address = countedAllocate(size, alignment))
+    return address;
+
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return countedAllocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return countedAllocate(size, alignment);
+}
+
+void operator delete(void* address) noexcept
+{
+  std::free(address);
+}
+
+void operator delete[](void* address) noexcept
+{
+  std::free(address);
+}
+
+void operator delete(void* address, std::size_t) noexcept
+{
+  std::free(address);
+}
+
+void operator delete[](void* address, std::size_t) noexcept
+{
+  std::free(address);
+}
+
+void operator delete(void* address, const std::nothrow_t&) noexcept
+{
+  std::free(address);
+}
+
+void operator delete[](void* address, const std::nothrow_t&) noexcept
+{
+  std::free(address);
+}
+
+void operator delete(void* address, std::align_val_t) noexcept
+{
+  std::free(address);
+}
+
+void operator delete[](void* address, std::align_val_t) noexcept
+{
+  std::free(address);
+}
+
+void operator delete(void* address, std::size_t, std::align_val_t) noexcept
+{
+  std::free(address);
+}
+
+void operator delete[](void* address, std::size_t, std::align_val_t) noexcept
+{
+  std::free(address);
+}
+
+void operator delete(void* address, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  std::free(address);
+}
+
+void operator delete[](void* address, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  std::free(address);
+}
+
 using safeconfig::Property;
 using safeconfig::ChoiceProperty;
 using safeconfig::NumericProperty;
@@ -15,116 +152,221 @@ using safeconfig::Group;
 using safeconfig::Configuration;
 
 using safeconfig::JsonLike;
+using safeconfig::NLohmannJsonWrapper;
+using safeconfig::StreamingLoader;
+using safeconfig::CompiledBinding;
+using safeconfig::ConfigurationLayers;
+using safeconfig::FrozenConfiguration;
+using safeconfig::JsonTextWriter;
 using Json = nlohmann::json;
 
-class NLohmannJsonWrapper : public JsonLike
+class Logging : public Group
 {
+  static inline const std::vector<std::string> defaultLoggingLevelChoices = { "trace", "debug", "info", "warn", "err", "critical", "off" };
+  static constexpr std::pair<int, int> defaultFlushPeriodInSecondsRange = { 0, 9000 };
+
+  // Shared by the level properties of all `Logging` groups
+  static inline const auto defaultLoggingLevelConstraint = std::make_shared<const ChoiceProperty::ConstraintType>(defaultLoggingLevelChoices);
+
 public:
-  NLohmannJsonWrapper(nlohmann::json& json)
-    : _json(json)
+  // The properties are allocated from `resource`, e.g. that of the configuration emplacing this group
+  Logging(std::string_view name, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    : Group(name)
+    , _level(safeconfig::allocateUnique<ChoiceProperty>(resource, "level", defaultLoggingLevelConstraint, resource))
+    , _period(safeconfig::allocateUnique<NumericProperty>(resource, "flushPeriodInSeconds", defaultFlushPeriodInSecondsRange, resource))
   {
   }
 
-  safeconfig::JsonProxy operator[](const std::string& key) const override
+  Logging(Logging&&) = default;
+  Logging& operator=(Logging&&) = default;
+
+  const std::string& getLoggingLevel() const
   {
-    return { std::make_unique<NLohmannJsonWrapper>(_json[key]) };
+    return _level->getValue<std::string>();
   }
 
-  bool isEmpty() const override
+  void setLoggingLevel(const std::string& level)
+  {
+    _level->setValue(level);
+  }
+
+  auto getFlushPeriodInSeconds() const
   {
-    return _json.is_null();
+    return _period->getValue<int>();
   }
 
-  operator int() const override
+  void setFlushPeriodInSeconds(const int& level)
   {
-    return static_cast<int>(_json);
+    _period->setValue(level);
   }
 
-  operator double() const override
+  void setLoggingLevelChoices(const std::vector<std::string>& choices)
   {
-    return static_cast<double>(_json);
+    _level->setConstraint(safeconfig::allocateShared<ChoiceProperty::ConstraintType>(_level->getMemoryResource(), choices, _level->getMemoryResource()));
   }
 
-  operator std::string() const override
+  void operator<<(const JsonLike& json) override
   {
-    return static_cast<std::string>(_json);
+    _level->setValue<std::string>(json.at(_level->getName()));
+    _period->setValue<int>(json.at(_period->getName()));
   }
 
-  void operator=(const int& value) override
+  void operator>>(JsonLike& json) const override
   {
-    _json = value;
+    json[_level->getName()] = _level->getValue<std::string>();
+    json[_period->getName()] = _period->getValue<int>();
   }
 
-  void operator=(const double& value) override
+  // Flushing is pointless with logging turned off
+  void collectInvariantErrors(safeconfig::ValidationReport& report) const override
   {
-    _json = value;
+    if (_level->isValid() && _period->isValid() && _level->getValue<std::string_view>() == "off" && _period->getValue<int>() != 0)
+      report.add(safeconfig::ValidationErrc::invariantViolation, _period.get());
   }
 
-  void operator=(const std::string& value) override
+protected:
+  void visitProperties(const std::function<void(Property&)>& visitor) override
   {
-    _json = value;
+    visitor(*_level);
+    visitor(*_period);
   }
 
-private:
-  Json& _json;
+  void visitProperties(const std::function<void(const Property&)>& visitor) const override
+  {
+    visitor(*_level);
+    visitor(*_period);
+  }
+
+  safeconfig::ResourcePtr<Property> _level;
+  safeconfig::ResourcePtr<Property> _period;
 };
 
-class Logging : public Group
+// Same as `Logging`, but declared at compile time
+struct LoggingSchema
 {
-  static inline const std::vector<std::string> defaultLoggingLevelChoices = { "trace", "debug", "info", "warn", "err", "critical", "off" };
-  static constexpr std::pair<int, int> defaultFlushPeriodInSecondsRange = { 0, 9000 };
+  static constexpr auto level = safeconfig::choiceField("level", { "trace", "debug", "info", "warn", "err", "critical", "off" }, "info");
+  static constexpr auto period = safeconfig::numericField("flushPeriodInSeconds", 0, 9000, 0);
 
+  //static constexpr auto badLevel = safeconfig::choiceField("level", { "trace", "debug" }, ""); // static_assert if used in a `SchemaGroup`
+};
+
+class CompactLogging : public safeconfig::SchemaGroup<LoggingSchema::level, LoggingSchema::period>
+{
 public:
-  Logging(std::string name)
-    : Group(std::move(name))
-    , _level(std::make_unique<ChoiceProperty>("level", defaultLoggingLevelChoices))
-    , _period(std::make_unique<NumericProperty>("flushPeriodInSeconds", defaultFlushPeriodInSecondsRange))
+  using SchemaGroup::SchemaGroup;
+
+  std::string_view getLoggingLevel() const
   {
+    return getValue<LoggingSchema::level>();
   }
 
-  Logging(Logging&&) = default;
-  Logging& operator=(Logging&&) = default;
+  int getFlushPeriodInSeconds() const
+  {
+    return getValue<LoggingSchema::period>();
+  }
+};
+
+// Exposes no properties, so it is only read and written through its `operator<<` and `operator>>`
+class Banner : public safeconfig::Group
+{
+public:
+  using Group::Group;
 
-  auto getLoggingLevel() const
+  void operator<<(const JsonLike& json) override
   {
-    return _level->getValue<std::string>();
+    std::string text = json.at(textKey);
+
+    if (text.empty())
+      throw std::runtime_error("Expected a banner text");
+
+    _text = std::move(text);
   }
 
-  void setLoggingLevel(const std::string& level)
+  void operator>>(JsonLike& json) const override
   {
-    _level->setValue(level);
+    json[textKey] = _text;
   }
 
-  auto getFlushPeriodInSeconds() const
+  const std::string& getText() const noexcept
   {
-    return _period->getValue<int>();
+    return _text;
   }
 
-  void setFlushPeriodInSeconds(const int& level)
+private:
+  inline static const std::string textKey = "text";
+
+  std::string _text = "hello";
+};
+
+// A read-only adapter that implements only what `JsonLike` requires, relying on its default implementations
+class ReadOnlyJson : public JsonLike
+{
+public:
+  ReadOnlyJson(const Json* json)
+    : _json(json)
   {
-    _period->setValue(level);
   }
 
-  void setLoggingLevelChoices(const std::vector<std::string>& choices)
+  bool isEmpty() const override
   {
-    _level->setConstraint(std::make_unique<ChoiceProperty::ConstraintType>(choices));
+    return !_json || _json->is_null();
   }
 
-  void operator<<(const JsonLike& json) override
+  operator safeconfig::RealType() const override
   {
-    _level->setValue<std::string>(json[_level->getName()]);
-    _period->setValue<int>(json[_period->getName()]);
+    return get().get<safeconfig::RealType>();
   }
 
-  void operator>>(JsonLike& json) const override
+  operator safeconfig::StringType() const override
   {
-    json[_level->getName()] = _level->getValue<std::string>();
-    json[_period->getName()] = _period->getValue<int>();
+    return get().get<safeconfig::StringType>();
   }
 
-protected:
-  std::unique_ptr<Property> _level;
-  std::unique_ptr<Property> _period;
+  operator safeconfig::IntegerType() const override
+  {
+    return get().get<safeconfig::IntegerType>();
+  }
+
+  void operator=(const safeconfig::RealType&) override
+  {
+    throw std::runtime_error("Expected a writable json");
+  }
+
+  void operator=(const safeconfig::StringType&) override
+  {
+    throw std::runtime_error("Expected a writable json");
+  }
+
+  void operator=(const safeconfig::IntegerType&) override
+  {
+    throw std::runtime_error("Expected a writable json");
+  }
+
+  safeconfig::JsonProxy operator[](const std::string& key) const override
+  {
+    const Json* member = nullptr;
+
+    if (_json && _json->is_object())
+    {
+      auto it = _json->find(key);
+
+      if (it != _json->end())
+        member = &*it;
+    }
+
+    return safeconfig::JsonProxy(std::in_place_type<ReadOnlyJson>, member);
+  }
+
+private:
+  const Json& get() const
+  {
+    if (!_json)
+      throw std::runtime_error("Expected a value");
+
+    return *_json;
+  }
+
+  const Json* _json;
 };
 
 class MyConfiguration : public Configuration
@@ -191,9 +433,15 @@ int main()
   //ASSERT_THROWS("Using an unknown value type in a choice property", choiceProperty.getValue<const char*>()); // static_assert
   ASSERT_THROWS("Setting an invalid choice property value", choiceProperty.setValue<std::string>("trace"));
   ASSERT_POSTCOND("Setting a valid choice property value", choiceProperty.setValue<std::string>("info"), choiceProperty.getValue<std::string>() == "info");
+  ASSERT_POSTCOND("Moving a valid choice property value", choiceProperty.setValue(std::string("crit")),
+    choiceProperty.getValue<std::string_view>() == "crit");
+  ASSERT_POSTCOND("Checking a choice by view", auto& choiceConstraint = static_cast<const ChoiceConstraint&>(choiceProperty.getConstraint()),
+    choiceConstraint.isValid(std::string_view("debug")) && !choiceConstraint.isValid(std::string_view("trace")) && !choiceConstraint.isValid(1));
 
   std::vector<int> choicePropertyChoices = { 1, 2, 3 };
-  choiceProperty.setConstraint(choicePropertyChoices);
+  ASSERT_POSTCOND("Switching the choices of a choice property from strings to integers", choiceProperty.setConstraint(choicePropertyChoices),
+    static_cast<const ChoiceConstraint&>(choiceProperty.getConstraint()).getStringChoices().empty()
+    && static_cast<const ChoiceConstraint&>(choiceProperty.getConstraint()).getIntegerChoices().size() == 3);
 
   ASSERT_THROWS("Choice property constraint changed. Old value is invalid", choiceProperty.getValue<std::string>());
   ASSERT_THROWS("Setting a choice property value of a wrong type", choiceProperty.setValue<std::string>("debug"));
@@ -203,11 +451,98 @@ int main()
   ASSERT_THROWS("Getting a choice property value of a wrong type", choiceProperty.getValue<std::string>());
   ASSERT_POSTCOND("Getting the choice property value of correct type", int value = choiceProperty.getValue<int>(), value == 1);
 
+  std::cout << "\n*** TEST: TypedProperty ***\n" << std::endl;
+
+  TypedNumericProperty<int> typedNumericProperty("Typed Numeric Property", { 0, 10 });
+  ASSERT_THROWS("Setting an invalid typed numeric property value", typedNumericProperty.setValue(11));
+  ASSERT_POSTCOND("Setting a valid typed numeric property value", typedNumericProperty.setValue(10), typedNumericProperty.getValue() == 10);
+  ASSERT_THROWS("Replacing the constraint of a typed property with an untyped one",
+    static_cast<Property&>(typedNumericProperty).setConstraint(std::make_unique<NumericConstraint>(0, 10)));
+  ASSERT_POSTCOND("Replacing the constraint of an untyped property with a typed one of the same type",
+    numericProperty.Property::setConstraint(std::make_shared<TypedNumericConstraint<int>>(0, 5)), numericProperty.getValue<int>() == 1);
+
+  TypedChoiceProperty<std::string> typedChoiceProperty("Typed Choice Property", std::vector<std::string>{ "debug", "info" });
+  ASSERT_THROWS("Getting an invalid (default) typed choice property value", typedChoiceProperty.getValue());
+  ASSERT_POSTCOND("Setting a valid typed choice property value", typedChoiceProperty.setValue("info"), typedChoiceProperty.getValue<std::string>() == "info");
+
+  std::cout << "\n*** TEST: SchemaGroup ***\n" << std::endl;
+
+  CompactLogging compactLogging("compactLogging");
+  ASSERT_POSTCOND("Getting a valid (default) schema group value", (void)0, compactLogging.getLoggingLevel() == "info");
+  ASSERT_THROWS("Setting an invalid schema group value", compactLogging.setValue<LoggingSchema::level>("offf"));
+  ASSERT_POSTCOND("Setting an invalid schema group value leaves the old value", (void)0, compactLogging.getLoggingLevel() == "info");
+  ASSERT_POSTCOND("Setting a valid schema group value",
+    compactLogging.setValue<LoggingSchema::period>(60), compactLogging.getFlushPeriodInSeconds() == 60);
+
+  Json compactLoggingJson;
+  compactLoggingJson["level"] = "warn";
+  compactLoggingJson["flushPeriodInSeconds"] = -1; // Bad value
+  ASSERT_THROWS("Reading an invalid schema group from json", compactLogging << NLohmannJsonWrapper(compactLoggingJson));
+  ASSERT_POSTCOND("Reading an invalid schema group from json leaves all old values", (void)0, compactLogging.getLoggingLevel() == "info");
+  ASSERT_POSTCOND("Validating an invalid schema group",
+    ValidationReport report = compactLogging.validate(NLohmannJsonWrapper(compactLoggingJson)), report.getErrors().size() == 1
+      && report.getPath(report.getErrors()[0]) == "compactLogging/flushPeriodInSeconds");
+
+  compactLoggingJson["flushPeriodInSeconds"] = 5;
+  ASSERT_POSTCOND("Reading a valid schema group from json", compactLogging << NLohmannJsonWrapper(compactLoggingJson),
+    compactLogging.getLoggingLevel() == "warn" && compactLogging.getFlushPeriodInSeconds() == 5);
+
+  std::cout << "\n*** TEST: InternedString ***\n" << std::endl;
+
+  InternedString level("level");
+  ASSERT_POSTCOND("Interning equal strings", (void)0,
+    level == InternedString(std::string("lev") + "el") && level != InternedString("levels") && level.str() == "level");
+  ASSERT_POSTCOND("Interning property names", ChoiceProperty otherLevel("level", std::vector<std::string>{ "on" }),
+    otherLevel.getInternedName() == level && &otherLevel.getName() == &level.str());
+
+  std::vector<InternedString> manyNames;
+  ASSERT_POSTCOND("Interning enough strings to grow the pool",
+    for (int i = 0; i < 200; ++i) manyNames.emplace_back("name" + std::to_string(i)),
+    InternedString::find("name0") == manyNames.front() && InternedString::find("name199") == manyNames.back() && !InternedString::find("name200"));
+
   std::cout << "\n*** TEST: Group ***\n" << std::endl;
 
+  Logging firstLogging("first");
+  Logging secondLogging("second");
+  ASSERT_POSTCOND("Sharing a constraint between groups", (void)0,
+    &firstLogging.findProperty("level")->getConstraint() == &secondLogging.findProperty("level")->getConstraint());
+  ASSERT_THROWS("Sharing a constraint of an unrelated type",
+    firstLogging.findProperty("level")->setConstraint(secondLogging.findProperty("flushPeriodInSeconds")->getSharedConstraint()));
+
+  // Shared constraints cannot be changed, so that no property sharing one is left with a stale validity
+  static_assert(!std::is_constructible_v<NumericProperty, std::string_view, std::shared_ptr<NumericConstraint>>);
+  static_assert(!std::is_assignable_v<NumericConstraint&, const NumericConstraint&>);
+  auto sharedBounds = std::make_shared<const NumericConstraint>(0, 10);
+  NumericProperty firstBounded("firstBounded", sharedBounds);
+  NumericProperty secondBounded("secondBounded", sharedBounds);
+  ASSERT_POSTCOND("Changing the bounds of one property that shares a constraint",
+    firstBounded.setValue(10); secondBounded.setValue(10); firstBounded.setConstraint(0, 5),
+    !firstBounded.isValid() && secondBounded.isValid() && &secondBounded.getConstraint() == sharedBounds.get());
+  ASSERT_POSTCOND("Finding a property allocates nothing",
+    std::size_t allocationCount = globalAllocationCount; const Property* found = firstLogging.findProperty("flushPeriodInSeconds"),
+    found && found->getName() == "flushPeriodInSeconds" && globalAllocationCount == allocationCount);
+
+  std::cout << "\n*** TEST: Arena allocation ***\n" << std::endl;
+
+  alignas(std::max_align_t) static std::byte arenaBuffer[16384];
+  std::pmr::monotonic_buffer_resource arena(arenaBuffer, sizeof(arenaBuffer), std::pmr::null_memory_resource());
+  {
+    Configuration arenaConfig("arenaConfig", &arena);
+    Configuration otherArenaConfig("otherArenaConfig", &arena);
+    ASSERT_POSTCOND("Emplacing a group into an arena-backed configuration", arenaConfig.emplace<Logging>("logging"),
+      arenaConfig.getMemoryResource() == &arena && arenaConfig.getTyped<Logging>("logging")->getFlushPeriodInSeconds() == 0);
+
+    // The names are interned by now, which is the only allocation from the global heap
+    ASSERT_POSTCOND("Emplacing a group into an arena-backed configuration allocates nothing from the global heap",
+      std::size_t allocationCount = globalAllocationCount; otherArenaConfig.emplace<Logging>("logging"),
+      globalAllocationCount == allocationCount);
+  }
+
+
   MyConfiguration myConfig("myConfig");
 
   std::shared_ptr<Logging> logging = myConfig.getLogging();
+  ASSERT_POSTCOND("Getting a group by view", (void)0, myConfig.get(std::string_view("logging")) == logging && myConfig.contains("logging"));
 
   ASSERT_THROWS("Getting an invalid (default) logging level", logging->getLoggingLevel());
   ASSERT_THROWS("Setting an invalid logging level", logging->setLoggingLevel("offf"));
@@ -250,9 +585,470 @@ int main()
 
   inputMyConfigJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 3; // All good
 
+  std::cout << "\n*** TEST: Validation ***\n" << std::endl;
+
+  Json candidateJson;
+  candidateJson["myConfig"]["logging"]["level"] = "offf"; // Bad value
+  candidateJson["myConfig"]["logging"]["flushPeriodInSeconds"] = "60"; // Bad type
+  ASSERT_POSTCOND("Validating an invalid configuration reports every error",
+    ValidationReport report = myConfig.validate(NLohmannJsonWrapper(candidateJson)), report.getErrors().size() == 2
+      && report.getPath(report.getErrors()[0]) == "myConfig/logging/level" && report.getErrors()[0].code == ValidationErrc::invalidValue
+      && report.getErrors()[1].code == ValidationErrc::typeMismatch);
+
+  ASSERT_POSTCOND("Validating through an adapter that relies on the default type checks reports every error",
+    ValidationReport report = myConfig.validate(ReadOnlyJson(&candidateJson)), report.getErrors().size() == 2
+      && report.getErrors()[1].code == ValidationErrc::typeMismatch);
+
+  candidateJson["myConfig"]["logging"]["level"] = "info";
+  candidateJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 3000000000u; // Out of the range of an `int`
+  ASSERT_POSTCOND("Validating an integer out of the range of the value type reports a type mismatch",
+    ValidationReport report = myConfig.validate(NLohmannJsonWrapper(candidateJson)), report.getErrors().size() == 1
+      && report.getErrors()[0].code == ValidationErrc::typeMismatch);
+
+  candidateJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 60;
+  ASSERT_POSTCOND("Validating a valid configuration reports no errors",
+    ValidationReport report = myConfig.validate(NLohmannJsonWrapper(candidateJson)), report.isValid());
+  ASSERT_POSTCOND("Validating a valid configuration through an adapter that relies on the default type checks reports no errors",
+    ValidationReport report = myConfig.validate(ReadOnlyJson(&candidateJson)), report.isValid());
+
+  Json missingGroupJson;
+  missingGroupJson["myConfig"]["otherGroup"] = 1; // The "logging" group is missing
+  const Json missingGroupJsonCopy = missingGroupJson;
+  ASSERT_THROWS("Reading an invalid configuration from json", myConfig << NLohmannJsonWrapper(missingGroupJson));
+  ASSERT_POSTCOND("Reading a configuration from json does not modify the json", (void)0, missingGroupJson == missingGroupJsonCopy);
+
   myConfig << NLohmannJsonWrapper(inputMyConfigJson); // Good
   myConfig >> NLohmannJsonWrapper(outputMyConfigJson); // Good
 
+  std::cout << "\n*** TEST: Parallel loading ***\n" << std::endl;
+
+  Json parallelJson = inputMyConfigJson;
+  parallelJson["myConfig"]["logging"]["level"] = "debug";
+  parallelJson["myConfig"]["logging"]["flushPeriodInSeconds"] = -1; // Bad value
+  ASSERT_THROWS("Loading an invalid configuration in parallel", myConfig.loadParallel(NLohmannJsonWrapper(parallelJson), 4));
+  ASSERT_POSTCOND("Loading an invalid configuration in parallel rolls it back", (void)0, logging->getLoggingLevel() == "info");
+
+  parallelJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 8;
+  ASSERT_POSTCOND("Loading a configuration in parallel", myConfig.loadParallel(NLohmannJsonWrapper(parallelJson), 4),
+    logging->getLoggingLevel() == "debug" && logging->getFlushPeriodInSeconds() == 8);
+
+  Configuration mixedConfig("mixed");
+  auto mixedLogging = mixedConfig.emplace<Logging>("logging");
+  auto mixedFirstBanner = mixedConfig.emplace<Banner>("first");
+  mixedConfig.emplace<Banner>("second");
+  Json mixedJson;
+  mixedJson["mixed"]["logging"] = inputMyConfigJson["myConfig"]["logging"];
+  mixedJson["mixed"]["first"]["text"] = "hello";
+  mixedJson["mixed"]["second"]["text"] = "hi";
+  mixedConfig << NLohmannJsonWrapper(mixedJson);
+  const std::string mixedLevel = mixedLogging->getLoggingLevel();
+  mixedJson["mixed"]["logging"] = parallelJson["myConfig"]["logging"];
+  mixedJson["mixed"]["first"]["text"] = "hey";
+  mixedJson["mixed"]["second"]["text"] = ""; // Bad value
+  ASSERT_THROWS("Loading an invalid group that exposes no properties in parallel", mixedConfig.loadParallel(NLohmannJsonWrapper(mixedJson), 4));
+  ASSERT_POSTCOND("Loading an invalid group that exposes no properties in parallel rolls all groups back", (void)0,
+    mixedLogging->getLoggingLevel() == mixedLevel && mixedFirstBanner->getText() == "hello");
+
+  myConfig << NLohmannJsonWrapper(inputMyConfigJson);
+
+  std::cout << "\n*** TEST: Transaction ***\n" << std::endl;
+
+  // Fresh, as the logging level choices of `myConfig` have been narrowed
+  MyConfiguration transactionConfig("myConfig");
+  transactionConfig << NLohmannJsonWrapper(inputMyConfigJson);
+  std::shared_ptr<Logging> transactionLogging = transactionConfig.getLogging();
+
+  Json transactionJson = inputMyConfigJson;
+  transactionJson["myConfig"]["logging"]["level"] = "debug";
+  transactionJson["myConfig"]["logging"]["flushPeriodInSeconds"] = -1; // Bad value
+  Transaction transaction(transactionConfig);
+  ASSERT_THROWS("Committing an invalid transaction", transaction.load(NLohmannJsonWrapper(transactionJson)).commit());
+  ASSERT_POSTCOND("Committing an invalid transaction applies no value", (void)0,
+    transactionLogging->getLoggingLevel() == "info" && transactionLogging->getFlushPeriodInSeconds() == 3 && transaction.empty());
+  ASSERT_THROWS("Committing a transaction that violates an invariant",
+    transaction.set("logging", "level", "off").set("logging", "flushPeriodInSeconds", 60).commit());
+  ASSERT_POSTCOND("Committing a transaction that violates an invariant rolls it back", (void)0,
+    transactionLogging->getLoggingLevel() == "info" && transactionLogging->getFlushPeriodInSeconds() == 3);
+  ASSERT_POSTCOND("Committing a transaction", transaction.set("logging", "level", "off").set("logging", "flushPeriodInSeconds", 0).commit(),
+    transactionLogging->getLoggingLevel() == "off" && transactionLogging->getFlushPeriodInSeconds() == 0);
+
+  Configuration bannerConfig("bannerConfig");
+  bannerConfig.emplace<Banner>("banner");
+  Json bannerJson;
+  bannerJson["text"] = "hi";
+  Transaction bannerTransaction(bannerConfig);
+  ASSERT_POSTCOND("Staging a group that exposes no properties", bannerTransaction.load("banner", NLohmannJsonWrapper(bannerJson)),
+    !bannerTransaction.empty());
+  ASSERT_THROWS("Committing a transaction that stages a group that exposes no properties", bannerTransaction.commit());
+
+  std::cout << "\n*** TEST: NumericBatch ***\n" << std::endl;
+
+  NumericBatch batch = NumericBatch::gather(transactionConfig);
+  const int tuningTable[] = { 1, 50, 101, 7 };
+  batch.add("tuning/table", tuningTable, 4, 0, 100);
+  std::vector<std::string> failedPaths;
+  ASSERT_POSTCOND("Validating numeric values in bulk",
+    batch.validate().forEachFailure([&](std::size_t index) { failedPaths.push_back(batch.getPath(index)); }),
+    failedPaths == std::vector<std::string>{ "tuning/table[2]" } && batch.getPath(0) == "myConfig/logging/flushPeriodInSeconds"
+      && batch.getProperty(0) == transactionLogging->findProperty("flushPeriodInSeconds"));
+
+  std::cout << "\n*** TEST: Lazy loading ***\n" << std::endl;
+
+  Json lazyJson = inputMyConfigJson;
+  lazyJson["myConfig"]["logging"]["flushPeriodInSeconds"] = -1; // Bad value
+  MyConfiguration lazyConfig("myConfig");
+  ASSERT_POSTCOND("Loading a configuration lazily", lazyConfig.loadLazy(std::make_shared<NLohmannJsonWrapper>(lazyJson)),
+    lazyConfig.isPending("logging") && !lazyConfig.validate().isValid());
+  ASSERT_THROWS("Accessing an invalid lazily loaded group", lazyConfig.getLogging());
+
+  lazyJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 8;
+  ASSERT_POSTCOND("Accessing a lazily loaded group loads it", auto lazyLogging = lazyConfig.getLogging(),
+    lazyLogging->getFlushPeriodInSeconds() == 8 && !lazyConfig.isPending("logging"));
+
+  Configuration outerConfig("outer");
+  auto nestedConfig = outerConfig.emplace<MyConfiguration>("myConfig");
+  Json outerJson;
+  outerJson["outer"]["myConfig"] = lazyJson;
+  ASSERT_POSTCOND("Loading the groups of a nested configuration lazily", outerConfig.loadLazy(std::make_shared<NLohmannJsonWrapper>(outerJson)),
+    !outerConfig.isPending("myConfig") && nestedConfig->isPending("logging"));
+  ASSERT_POSTCOND("Accessing a lazily loaded group of a nested configuration loads it", auto nestedLogging = nestedConfig->getLogging(),
+    nestedLogging->getFlushPeriodInSeconds() == 8 && !nestedConfig->isPending("logging"));
+
+  std::cout << "\n*** TEST: Incremental update ***\n" << std::endl;
+
+  Json updateJson = inputMyConfigJson;
+  ASSERT_POSTCOND("Updating a configuration from unchanged json", auto changes = myConfig.update(NLohmannJsonWrapper(updateJson)), changes.empty());
+
+  updateJson["myConfig"]["logging"]["level"] = "offf"; // Bad value
+  updateJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 4;
+  ASSERT_THROWS("Updating a configuration with an invalid value", myConfig.update(NLohmannJsonWrapper(updateJson)));
+  ASSERT_POSTCOND("Updating a configuration with an invalid value does not modify it", (void)0, logging->getFlushPeriodInSeconds() == 3);
+
+  updateJson["myConfig"]["logging"]["level"] = "info";
+  ASSERT_POSTCOND("Updating a configuration with a changed value",
+    auto changes = myConfig.update(NLohmannJsonWrapper(updateJson)),
+    changes.size() == 1 && changes.contains("myConfig/logging/flushPeriodInSeconds") && changes.contains("myConfig/logging")
+      && !changes.contains("myConfig/logging/level") && logging->getFlushPeriodInSeconds() == 4);
+
+  Json invariantUpdateJson = inputMyConfigJson;
+  invariantUpdateJson["myConfig"]["logging"]["level"] = "off";
+  invariantUpdateJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 60; // Flushing with logging turned off
+  const std::string levelBeforeUpdate = transactionLogging->getLoggingLevel();
+  const int periodBeforeUpdate = transactionLogging->getFlushPeriodInSeconds();
+  ASSERT_THROWS("Updating a configuration with values that violate an invariant",
+    transactionConfig.update(NLohmannJsonWrapper(invariantUpdateJson)));
+  ASSERT_POSTCOND("Updating a configuration with values that violate an invariant does not modify it", (void)0,
+    transactionLogging->getLoggingLevel() == levelBeforeUpdate && transactionLogging->getFlushPeriodInSeconds() == periodBeforeUpdate);
+
+  invariantUpdateJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 0;
+  ASSERT_POSTCOND("Updating a configuration with values that satisfy its invariants",
+    transactionConfig.update(NLohmannJsonWrapper(invariantUpdateJson)),
+    transactionLogging->getLoggingLevel() == "off" && transactionLogging->getFlushPeriodInSeconds() == 0);
+
+  Configuration bannersConfig("banners");
+  auto firstBanner = bannersConfig.emplace<Banner>("first");
+  auto secondBanner = bannersConfig.emplace<Banner>("second");
+  Json bannersJson;
+  bannersJson["banners"]["first"]["text"] = "hello";
+  bannersJson["banners"]["second"]["text"] = "hi";
+  ASSERT_POSTCOND("Updating groups that expose no properties reports only the changed ones",
+    auto changes = bannersConfig.update(NLohmannJsonWrapper(bannersJson)),
+    changes.size() == 1 && changes.contains("banners/second") && !changes.contains("banners/first")
+      && secondBanner->getText() == "hi");
+
+  bannersJson["banners"]["first"]["text"] = "hey";
+  bannersJson["banners"]["second"]["text"] = ""; // Bad value
+  ASSERT_THROWS("Updating groups that expose no properties with an invalid value", bannersConfig.update(NLohmannJsonWrapper(bannersJson)));
+  ASSERT_POSTCOND("Updating groups that expose no properties with an invalid value does not modify them", (void)0,
+    firstBanner->getText() == "hello" && secondBanner->getText() == "hi");
+
+  std::cout << "\n*** TEST: ChangeDispatcher ***\n" << std::endl;
+
+  ChangeDispatcher dispatcher;
+  int loggingNotifications = 0;
+  int levelNotifications = 0;
+  auto loggingSubscription = dispatcher.subscribe("myConfig/logging", [&](const ChangeSet&) { ++loggingNotifications; });
+  auto levelSubscription = dispatcher.subscribe("myConfig/logging/level", [&](const ChangeSet&) { ++levelNotifications; });
+
+  updateJson["myConfig"]["logging"]["level"] = "debug";
+  updateJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 5;
+  ASSERT_POSTCOND("Dispatching the changes of an update once per subscriber",
+    dispatcher.dispatch(myConfig.update(NLohmannJsonWrapper(updateJson))), loggingNotifications == 1 && levelNotifications == 1);
+
+  updateJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 6;
+  levelSubscription.cancel();
+  ASSERT_POSTCOND("Dispatching only to the subscribers of changed paths",
+    dispatcher.dispatch(myConfig.update(NLohmannJsonWrapper(updateJson))), loggingNotifications == 2 && levelNotifications == 1);
+
+  ASSERT_POSTCOND("Setting a value notifies no one by itself", logging->setFlushPeriodInSeconds(7), loggingNotifications == 2);
+
+  ChangeSet setValueChanges;
+  setValueChanges.add("myConfig/logging/flushPeriodInSeconds", *logging, logging->findProperty("flushPeriodInSeconds"));
+  ASSERT_POSTCOND("Dispatching the change of a set value", dispatcher.dispatch(setValueChanges), loggingNotifications == 3);
+
+  {
+    ChangeDispatcher attachedDispatcher(myConfig);
+    ASSERT_THROWS("Attaching a second dispatcher to a configuration", ChangeDispatcher{ myConfig });
+
+    int attachedLoggingNotifications = 0;
+    int attachedLevelNotifications = 0;
+    auto attachedLoggingSubscription = attachedDispatcher.subscribe("myConfig/logging", [&](const ChangeSet&) { ++attachedLoggingNotifications; });
+    auto attachedLevelSubscription = attachedDispatcher.subscribe("myConfig/logging/level", [&](const ChangeSet&) { ++attachedLevelNotifications; });
+    ASSERT_POSTCOND("Setting a watched value notifies the subscribers of its path", logging->setLoggingLevel("info"),
+      attachedLoggingNotifications == 1 && attachedLevelNotifications == 1);
+    ASSERT_POSTCOND("Setting a watched value notifies only the subscribers of its path", logging->setFlushPeriodInSeconds(8),
+      attachedLoggingNotifications == 2 && attachedLevelNotifications == 1);
+    ASSERT_THROWS("Setting an invalid watched value", logging->setLoggingLevel("offf"));
+    ASSERT_POSTCOND("Setting an invalid watched value notifies no one", (void)0,
+      attachedLoggingNotifications == 2 && attachedLevelNotifications == 1);
+
+    ASSERT_POSTCOND("Updating an attached configuration dispatches its changes once",
+      myConfig.update(NLohmannJsonWrapper(updateJson)), attachedLoggingNotifications == 3 && attachedLevelNotifications == 2);
+    ASSERT_POSTCOND("Committing a transaction on an attached configuration dispatches its changes",
+      Transaction(myConfig).set("logging", "flushPeriodInSeconds", 9).commit(),
+      attachedLoggingNotifications == 4 && attachedLevelNotifications == 2);
+    ASSERT_POSTCOND("Loading an attached configuration dispatches a change of all of it, once",
+      myConfig << NLohmannJsonWrapper(inputMyConfigJson), attachedLoggingNotifications == 5 && attachedLevelNotifications == 3);
+
+    attachedLevelSubscription.cancel();
+    ASSERT_POSTCOND("Setting a value no longer watched by a cancelled subscription", logging->setLoggingLevel("debug"),
+      attachedLoggingNotifications == 6 && attachedLevelNotifications == 3);
+
+    attachedLoggingSubscription.cancel();
+    ASSERT_POSTCOND("Cancelling all subscriptions of a property stops observing it", (void)0,
+      !logging->findProperty("level")->getObserver() && !logging->findProperty("flushPeriodInSeconds")->getObserver());
+  }
+
+  myConfig << NLohmannJsonWrapper(inputMyConfigJson);
+
+  std::cout << "\n*** TEST: Snapshot ***\n" << std::endl;
+
+  std::stringstream snapshotStream;
+  writeSnapshot(myConfig, snapshotStream);
+  const std::string snapshotData = snapshotStream.str();
+  SnapshotView snapshot(snapshotData.data(), snapshotData.size());
+
+  ASSERT_POSTCOND("Reading a value straight from a snapshot", auto entry = snapshot.find("myConfig/logging/level"),
+    entry && entry->getValue<std::string_view>() == logging->getLoggingLevel() && snapshot.getSchemaDigest() == computeSchemaDigest(myConfig));
+  ASSERT_THROWS("Reading a value of a wrong type from a snapshot", snapshot.find("myConfig/logging/level")->getValue<int>());
+  ASSERT_THROWS("Reading a corrupt snapshot", SnapshotView(snapshotData.data(), snapshotData.size() - 1));
+
+  logging->setFlushPeriodInSeconds(9);
+  ASSERT_POSTCOND("Loading a configuration from a snapshot", loadSnapshot(myConfig, snapshot), logging->getFlushPeriodInSeconds() == 3);
+
+  {
+    Json staleJson = inputMyConfigJson;
+    staleJson["myConfig"]["logging"]["flushPeriodInSeconds"] = -1; // Bad value, never to be read
+    MyConfiguration lazySnapshotConfig("myConfig");
+    ChangeDispatcher snapshotDispatcher(lazySnapshotConfig);
+    int snapshotNotifications = 0;
+    auto snapshotSubscription = snapshotDispatcher.subscribe("myConfig/logging", [&](const ChangeSet&) { ++snapshotNotifications; });
+    lazySnapshotConfig.loadLazy(std::make_shared<NLohmannJsonWrapper>(staleJson));
+    ASSERT_POSTCOND("Loading a snapshot supersedes lazily loaded groups and notifies the attached dispatcher",
+      loadSnapshot(lazySnapshotConfig, snapshot),
+      !lazySnapshotConfig.isPending("logging") && snapshotNotifications == 2 && lazySnapshotConfig.getLogging()->getFlushPeriodInSeconds() == 3);
+  }
+
+  logging->setLoggingLevelChoices({ "debug" }); // Changes the schema digest; "info" is no longer valid
+  ASSERT_THROWS("Loading a snapshot that fails the changed constraints", loadSnapshot(myConfig, snapshot));
+  logging->setLoggingLevelChoices(loggingLevelChoices);
+
+  myConfig << NLohmannJsonWrapper(inputMyConfigJson);
+
+  std::cout << "\n*** TEST: StreamingLoader ***\n" << std::endl;
+
+  StreamingLoader loader(myConfig);
+  ASSERT_THROWS("Streaming an invalid configuration", loader.load(R"({"myConfig": {"logging": {"level": "offf", "flushPeriodInSeconds": 1}}})"));
+  ASSERT_THROWS("Streaming a configuration with a value of a wrong type", loader.load(R"({"myConfig": {"logging": {"level": 1}}})"));
+  ASSERT_THROWS("Streaming an integer above the range of `int`",
+    loader.load(R"({"myConfig": {"logging": {"level": "info", "flushPeriodInSeconds": 4294967299}}})"));
+  ASSERT_THROWS("Streaming an integer below the range of `int`",
+    loader.load(R"({"myConfig": {"logging": {"level": "info", "flushPeriodInSeconds": -4294967291}}})"));
+  ASSERT_THROWS("Streaming a configuration with a missing value", loader.load(R"({"myConfig": {"logging": {"level": "info"}}})"));
+  ASSERT_THROWS("Streaming malformed json", loader.load(R"({"myConfig": )"));
+  ASSERT_POSTCOND("Streaming a valid configuration with unknown keys",
+    loader.load(R"({"other": [1, {"a": 2}], "myConfig": {"unknown": {"x": 1}, "logging": {"level": "debug", "flushPeriodInSeconds": 7}}})"),
+    logging->getLoggingLevel() == "debug" && logging->getFlushPeriodInSeconds() == 7);
+
+  Json staleStreamJson = inputMyConfigJson;
+  staleStreamJson["myConfig"]["logging"]["flushPeriodInSeconds"] = -1; // Bad value, never to be read
+  MyConfiguration lazyStreamConfig("myConfig");
+  StreamingLoader lazyLoader(lazyStreamConfig);
+  lazyStreamConfig.loadLazy(std::make_shared<NLohmannJsonWrapper>(staleStreamJson));
+  ASSERT_THROWS("Streaming a configuration without a group deferred by a lazy load", lazyLoader.load(R"({"myConfig": {}})"));
+  ASSERT_POSTCOND("Streaming a configuration supersedes groups deferred by a lazy load",
+    lazyLoader.load(R"({"myConfig": {"logging": {"level": "debug", "flushPeriodInSeconds": 6}}})"),
+    !lazyStreamConfig.isPending("logging") && lazyStreamConfig.getLogging()->getFlushPeriodInSeconds() == 6);
+
+  StreamingLoader bannerLoader(bannerConfig);
+  auto streamedBanner = bannerConfig.getTyped<Banner>("banner");
+  ASSERT_THROWS("Streaming malformed json within a group that exposes no properties",
+    bannerLoader.load(R"({"bannerConfig": {"banner": {"text": )"));
+  ASSERT_POSTCOND("Streaming again after malformed json within a group that exposes no properties",
+    bannerLoader.load(R"({"bannerConfig": {"banner": {"text": "hi"}}})"), streamedBanner->getText() == "hi");
+
+  myConfig << NLohmannJsonWrapper(inputMyConfigJson);
+
+  std::cout << "\n*** TEST: CompiledBinding ***\n" << std::endl;
+
+  CompiledBinding binding(myConfig);
+  Json bindingJson = Json::parse(R"({"other": [1, {"a": 2}], "myConfig": {"unknown": {"x": 1}, "logging": {"level": "debug", "flushPeriodInSeconds": 5}}})");
+  ASSERT_POSTCOND("Loading a configuration through a compiled binding, skipping unknown keys", binding.load(NLohmannJsonWrapper(bindingJson)),
+    binding.size() == 2 && logging->getLoggingLevel() == "debug" && logging->getFlushPeriodInSeconds() == 5);
+
+  bindingJson["myConfig"]["logging"]["level"] = "info";
+  bindingJson["myConfig"]["logging"]["flushPeriodInSeconds"] = -1; // Bad value
+  ASSERT_THROWS("Loading an invalid configuration through a compiled binding", binding.load(NLohmannJsonWrapper(bindingJson)));
+  ASSERT_POSTCOND("Loading an invalid configuration through a compiled binding modifies nothing", (void)0, logging->getLoggingLevel() == "debug");
+
+  {
+    ChangeDispatcher bindingDispatcher(myConfig);
+    int bindingNotifications = 0;
+    auto bindingSubscription = bindingDispatcher.subscribe("myConfig/logging/level", [&](const ChangeSet&) { ++bindingNotifications; });
+    ASSERT_THROWS("Loading an invalid configuration through a compiled binding notifies no one", binding.load(NLohmannJsonWrapper(bindingJson)));
+    bindingJson["myConfig"]["logging"]["flushPeriodInSeconds"] = 5;
+    ASSERT_POSTCOND("Loading a configuration through a compiled binding notifies the attached dispatcher", binding.load(NLohmannJsonWrapper(bindingJson)),
+      bindingNotifications == 1 && logging->getLoggingLevel() == "info");
+  }
+
+  bindingJson["myConfig"]["logging"].erase("flushPeriodInSeconds");
+  ASSERT_THROWS("Loading a configuration with a missing value through a compiled binding", binding.load(NLohmannJsonWrapper(bindingJson)));
+
+  CompiledBinding mixedBinding(mixedConfig);
+  mixedJson["mixed"]["second"]["text"] = ""; // Bad value
+  ASSERT_THROWS("Loading an invalid group that exposes no properties through a compiled binding", mixedBinding.load(NLohmannJsonWrapper(mixedJson)));
+  ASSERT_POSTCOND("Loading an invalid group that exposes no properties through a compiled binding modifies nothing", (void)0,
+    mixedLogging->getLoggingLevel() == mixedLevel && mixedFirstBanner->getText() == "hello");
+
+  myConfig << NLohmannJsonWrapper(inputMyConfigJson);
+
+  std::cout << "\n*** TEST: ConfigurationLayers ***\n" << std::endl;
+
+  auto defaultsJson = std::make_shared<Json>(Json::parse(R"({"myConfig": {"logging": {"level": "info", "flushPeriodInSeconds": 10}}})"));
+  auto overridesJson = std::make_shared<Json>(Json::parse(R"({"myConfig": {"logging": {"level": "debug"}}})"));
+  auto invalidOverridesJson = std::make_shared<Json>(Json::parse(R"({"myConfig": {"logging": {"flushPeriodInSeconds": -1}}})"));
+
+  ConfigurationLayers layers(myConfig);
+  layers.addLayer("defaults", std::make_shared<NLohmannJsonWrapper>(*defaultsJson));
+  std::size_t overridesLayer = 0;
+  ASSERT_POSTCOND("Overriding a value by a layer on top",
+    overridesLayer = layers.addLayer("overrides", std::make_shared<NLohmannJsonWrapper>(*overridesJson)),
+    logging->getLoggingLevel() == "debug" && logging->getFlushPeriodInSeconds() == 10 && layers.findSource("myConfig/logging/level") == overridesLayer);
+  ASSERT_THROWS("Setting a layer with an invalid value", layers.setLayer(overridesLayer, std::make_shared<NLohmannJsonWrapper>(*invalidOverridesJson)));
+  ASSERT_POSTCOND("Clearing a layer falls back to the layers below", layers.setLayer(overridesLayer, nullptr),
+    logging->getLoggingLevel() == "info" && logging->getFlushPeriodInSeconds() == 10);
+
+  {
+    ChangeDispatcher layersDispatcher(myConfig);
+    int levelLayerNotifications = 0;
+    int periodLayerNotifications = 0;
+    auto levelSubscription = layersDispatcher.subscribe("myConfig/logging/level", [&](const ChangeSet&) { ++levelLayerNotifications; });
+    auto periodSubscription = layersDispatcher.subscribe("myConfig/logging/flushPeriodInSeconds", [&](const ChangeSet&) { ++periodLayerNotifications; });
+    ASSERT_THROWS("Setting a layer with an invalid value notifies no one",
+      layers.setLayer(overridesLayer, std::make_shared<NLohmannJsonWrapper>(*invalidOverridesJson)));
+    ASSERT_POSTCOND("Setting a layer notifies the subscribers of the values it changes",
+      layers.setLayer(overridesLayer, std::make_shared<NLohmannJsonWrapper>(*overridesJson)),
+      logging->getLoggingLevel() == "debug" && levelLayerNotifications == 1 && periodLayerNotifications == 0);
+  }
+
+  auto bannerLayerJson = std::make_shared<Json>(Json::parse(R"({"mixed": {"first": {"text": "layered"}}})"));
+  ConfigurationLayers mixedLayers(mixedConfig);
+  std::size_t bannerLayer = 0;
+  ASSERT_POSTCOND("Layering a group that exposes no properties",
+    bannerLayer = mixedLayers.addLayer("banner", std::make_shared<NLohmannJsonWrapper>(*bannerLayerJson)),
+    mixedFirstBanner->getText() == "layered" && mixedLayers.findSource("mixed/first") == bannerLayer);
+  ASSERT_POSTCOND("Clearing the only layer of a group that exposes no properties restores it", mixedLayers.setLayer(bannerLayer, nullptr),
+    mixedFirstBanner->getText() == "hello" && !mixedLayers.findSource("mixed/first"));
+
+  myConfig << NLohmannJsonWrapper(inputMyConfigJson);
+
+  std::cout << "\n*** TEST: FrozenConfiguration ***\n" << std::endl;
+
+  FrozenConfiguration frozenConfig(myConfig);
+  ASSERT_POSTCOND("Reading a value of a frozen configuration by path", auto id = frozenConfig.find("myConfig/logging/level"),
+    id && frozenConfig.getString(*id) == logging->getLoggingLevel() && frozenConfig.validate().empty());
+
+  Json frozenJson;
+  ASSERT_POSTCOND("Writing a frozen configuration as json", frozenConfig.write(NLohmannJsonWrapper(frozenJson)), frozenJson == outputMyConfigJson);
+
+  logging->setFlushPeriodInSeconds(11);
+  ASSERT_POSTCOND("Diffing frozen configurations", auto changed = frozenConfig.diff(FrozenConfiguration(myConfig)),
+    changed.size() == 1 && frozenConfig.getPath(changed.front()) == "myConfig/logging/flushPeriodInSeconds");
+
+  myConfig << NLohmannJsonWrapper(inputMyConfigJson);
+
+  std::cout << "\n*** TEST: JsonTextWriter ***\n" << std::endl;
+
+  std::ostringstream outputMyConfigText;
+  ASSERT_POSTCOND("Writing a configuration as json text",
+    myConfig >> JsonTextWriter(outputMyConfigText), Json::parse(outputMyConfigText.str()) == outputMyConfigJson);
+
+  std::string outputText;
+  JsonTextWriter writer(outputText);
+  JsonProxy member = writer[std::string("a")];
+  writer[std::string("b")] = std::string("\"quoted\"");
+  ASSERT_THROWS("Writing json out of order", member = 1);
+  writer.finish();
+  ASSERT_POSTCOND("Writing an unassigned member and escaped strings", (void)0, outputText == R"({"a":null,"b":"\"quoted\""})");
+
+  std::cout << "\n*** TEST: Instrumentation ***\n" << std::endl;
+
+  std::ostringstream instrumentationText;
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+  ASSERT_POSTCOND("Exporting instrumentation counters", safeconfig::writeInstrumentation(myConfig, instrumentationText),
+    instrumentationText.str().find("\nsafeconfig_group_loads_total{path=\"myConfig/logging\"} ") != std::string::npos
+      && logging->findProperty("level")->getCounters().reads.get() > 0);
+#else
+  ASSERT_POSTCOND("Exporting instrumentation counters while disabled", safeconfig::writeInstrumentation(myConfig, instrumentationText),
+    instrumentationText.str().rfind("# ", 0) == 0);
+#endif
+
+  std::cout << "\n*** TEST: PropertyHandle ***\n" << std::endl;
+
+  ASSERT_THROWS("Resolving a handle to a property that does not exist", PropertyHandle<int>(myConfig, "logging", "levelll"));
+  ASSERT_THROWS("Resolving a handle of a wrong value type", PropertyHandle<int>(myConfig, "logging", "level"));
+  ASSERT_POSTCOND("Reading a property through a resolved handle",
+    PropertyHandle<std::string> levelHandle(myConfig, "logging", "level"), *levelHandle == "info");
+
+  std::cout << "\n*** TEST: CachedProperty ***\n" << std::endl;
+
+  AtomicConfiguration<MyConfiguration> atomicConfig;
+  CachedProperty<std::string, MyConfiguration> cachedLevel(atomicConfig, "logging", "level");
+  ASSERT_THROWS("Reading a cached property before anything is published", cachedLevel.get());
+
+  Json reloadJson = inputMyConfigJson;
+  atomicConfig.reload(NLohmannJsonWrapper(reloadJson), "myConfig");
+  ASSERT_POSTCOND("Reading a cached property twice returns the cached value",
+    const std::string* first = &cachedLevel.get(), *first == "info" && &cachedLevel.get() == first);
+
+  reloadJson["myConfig"]["logging"]["level"] = "debug";
+  atomicConfig.reload(NLohmannJsonWrapper(reloadJson), "myConfig");
+  ASSERT_POSTCOND("Reading a cached property after a reload", (void)0, *cachedLevel == "debug");
+
+  PropertyHandle<std::string> followingLevel(atomicConfig, "logging", "level");
+  reloadJson["myConfig"]["logging"]["level"] = "warn";
+  atomicConfig.reload(NLohmannJsonWrapper(reloadJson), "myConfig");
+  ASSERT_POSTCOND("Reading a handle that follows an AtomicConfiguration after a reload", (void)0, *followingLevel == "warn");
+
+  // One thread at a time per handle; a copy follows the same source
+  std::string levelOnThread;
+  std::thread([followingCopy = followingLevel, &levelOnThread] { levelOnThread = *followingCopy; }).join();
+  ASSERT_POSTCOND("Reading a copy of a following handle on another thread", (void)0, levelOnThread == "warn");
+
+  auto lazySnapshot = std::make_shared<MyConfiguration>("myConfig");
+  lazySnapshot->loadLazy(std::make_shared<NLohmannJsonWrapper>(lazyJson));
+  ASSERT_POSTCOND("Publishing a lazily loaded snapshot loads its groups", atomicConfig.publish(lazySnapshot),
+    !lazySnapshot->isPending("logging") && *followingLevel == "info");
+
+  {
+    CachedProperty<std::string, MyConfiguration> scopedLevel(atomicConfig, "logging", "level");
+    ASSERT_POSTCOND("Reading a cached property holds on to its snapshot", (void)scopedLevel.get(), lazySnapshot.use_count() > 2);
+  }
+
+  atomicConfig.reload(NLohmannJsonWrapper(reloadJson), "myConfig");
+  ASSERT_POSTCOND("Reading a cached property releases the snapshots held for destroyed ones",
+    (void)cachedLevel.get(), *followingLevel == "warn" && lazySnapshot.use_count() == 1);
+
   std::cout << std::endl;
   std::cout << "outputMyConfigJson:" << std::endl;
   std::cout << outputMyConfigJson << std::endl;
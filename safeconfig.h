@@ -1,14 +1,36 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+#include <chrono>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <typeinfo>
+#include <unordered_map>
 #include <utility>
+#include <variant>
 #include <vector>
 
 namespace safeconfig
@@ -42,6 +64,10 @@ namespace safeconfig
       std::is_same_v<ValueType, StringType> ? ValueId::string :
       ValueId::unknown;
 
+    // For a `T&&` overload next to a `const T&` one: deduces only for (non-const) rvalues, which it can move from
+    template<class T>
+    using EnableIfRvalue = std::enable_if_t<!std::is_reference_v<T> && !std::is_const_v<T>>;
+
     inline std::string valueNameFromValueId(ValueId id)
     {
       std::string name;
@@ -68,11 +94,132 @@ namespace safeconfig
     }
   }
 
+  // Counters for finding hot and expensive configuration paths, maintained if `SAFECONFIG_ENABLE_INSTRUMENTATION` is
+  // defined (consistently across translation units); otherwise neither the counters nor the code updating them
+  // exist. They are exposed by `Property::getCounters()`, `Group::getCounters()` and `getJsonProxyCounters()`,
+  // and exported by `writeInstrumentation` of "safeconfig_instrumentation.h".
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+#define SAFECONFIG_INSTRUMENT(...) __VA_ARGS__
+#else
+#define SAFECONFIG_INSTRUMENT(...)
+#endif
+
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+  inline namespace instrumentation
+  {
+    // A relaxed atomic counter; copies take a snapshot, so that instrumented classes remain copyable and movable
+    class Counter
+    {
+    public:
+      Counter() = default;
+
+      Counter(const Counter& other) noexcept
+        : _value(other.get())
+      {}
+
+      Counter& operator=(const Counter& other) noexcept
+      {
+        _value.store(other.get(), std::memory_order_relaxed);
+        return *this;
+      }
+
+      void add(std::uint64_t count = 1) noexcept
+      {
+        _value.fetch_add(count, std::memory_order_relaxed);
+      }
+
+      std::uint64_t get() const noexcept
+      {
+        return _value.load(std::memory_order_relaxed);
+      }
+
+    private:
+      std::atomic<std::uint64_t> _value{ 0 };
+    };
+
+    struct LatencyCounters
+    {
+      Counter calls;
+      Counter failures;
+      Counter nanoseconds;
+    };
+
+    // Records a call into `counters` when going out of scope; a call left by an exception counts as failed
+    class LatencyRecorder
+    {
+    public:
+      explicit LatencyRecorder(LatencyCounters& counters) noexcept
+        : _counters(counters)
+        , _exceptionCount(std::uncaught_exceptions())
+        , _start(std::chrono::steady_clock::now())
+      {}
+
+      LatencyRecorder(const LatencyRecorder&) = delete;
+      LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+      ~LatencyRecorder()
+      {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start);
+
+        _counters.calls.add();
+        _counters.nanoseconds.add(static_cast<std::uint64_t>(elapsed.count()));
+
+        if (std::uncaught_exceptions() > _exceptionCount)
+          _counters.failures.add();
+      }
+
+    private:
+      LatencyCounters& _counters;
+      int _exceptionCount;
+      std::chrono::steady_clock::time_point _start;
+    };
+
+    struct PropertyCounters
+    {
+      // Of `getValue`
+      Counter reads;
+
+      // Of `setValue` and `setValueModel`
+      Counter writes;
+
+      // Constraint checks, and how many of them failed
+      Counter validations;
+      Counter validationFailures;
+    };
+
+    // Of loading a group from json (`operator<<`), and of writing it to json (`operator>>`), as performed by
+    // the enclosing `Configuration`
+    struct GroupCounters
+    {
+      LatencyCounters loads;
+      LatencyCounters serializations;
+    };
+
+    // Only the heap adapters of `JsonProxy` are counted; other allocations, e.g. of strings read from json or of
+    // properties, are not (for those, see the memory resource passed to `Configuration`)
+    struct JsonProxyCounters
+    {
+      // `JsonLike` adapters held on the heap, as too large to be stored inside the proxy or passed by `std::unique_ptr`
+      Counter heapAdapters;
+    };
+
+    inline JsonProxyCounters& getJsonProxyCounters() noexcept
+    {
+      static JsonProxyCounters counters;
+      return counters;
+    }
+  }
+#endif
+
+  // Holds a single value of one of the supported value types inline (no heap allocation beyond what the
+  // value type itself needs, e.g. a `std::string` that does not fit its small-string buffer)
   class ValueModel
   {
   public:
-    ValueModel() = default;
-    virtual ~ValueModel() = default;
+    // Holds a default-initialized value of the type identified by `valueId`
+    explicit ValueModel(ValueId valueId)
+      : _value(storageFromValueId(valueId))
+    {}
 
     template<class TValueType>
     const TValueType& getValue() const;
@@ -80,11 +227,86 @@ namespace safeconfig
     template<class TValueType>
     void setValue(const TValueType& value);
 
-    virtual ValueId getValueId() const noexcept = 0;
+    template<class TValueType, class = EnableIfRvalue<TValueType>>
+    void setValue(TValueType&& value);
+
+    // Requires `getValueId() == valueIdFromValueType<TValueType>`
+    template<class TValueType>
+    const TValueType& getValueUnchecked() const noexcept
+    {
+      return *std::get_if<TValueType>(&_value);
+    }
+
+    // Requires `getValueId() == valueIdFromValueType<TValueType>`
+    template<class TValueType>
+    void setValueUnchecked(TValueType value)
+    {
+      *std::get_if<TValueType>(&_value) = std::move(value);
+    }
+
+    // Requires `getValueId() == ValueId::string`; reuses the capacity of the held string
+    void assignStringUnchecked(std::string_view value)
+    {
+      std::get_if<StringType>(&_value)->assign(value.data(), value.size());
+    }
+
+    ValueId getValueId() const noexcept
+    {
+      return static_cast<ValueId>(_value.index());
+    }
+
+    bool operator==(const ValueModel& other) const noexcept
+    {
+      return _value == other._value;
+    }
+
+    bool operator!=(const ValueModel& other) const noexcept
+    {
+      return !(*this == other);
+    }
+
+  protected:
+    // Alternatives are ordered such that `_value.index()` is the `ValueId` of the held value
+    using Storage = std::variant<IntegerType, StringType, RealType>;
+
+    static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(ValueId::integer), Storage>, IntegerType>);
+    static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(ValueId::string), Storage>, StringType>);
+    static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(ValueId::real), Storage>, RealType>);
 
-    virtual bool operator==(const ValueModel& other) const noexcept = 0;
+    template<class TValueType>
+    ValueModel(std::in_place_type_t<TValueType> type, TValueType value)
+      : _value(type, std::move(value))
+    {}
+
+    template<class TValueType>
+    TValueType& getValueUnchecked() noexcept
+    {
+      return *std::get_if<TValueType>(&_value);
+    }
 
   private:
+    static Storage storageFromValueId(ValueId id)
+    {
+      Storage storage;
+
+      switch (id)
+      {
+      case ValueId::real:
+        storage.emplace<RealType>();
+        break;
+      case ValueId::integer:
+        storage.emplace<IntegerType>();
+        break;
+      case ValueId::string:
+        storage.emplace<StringType>();
+        break;
+      default:
+        throw std::runtime_error("Not implemented");
+      }
+
+      return storage;
+    }
+
     std::string errMsgForBadGetValue(ValueId badValueId) const
     {
       return "Invalid usage of `getValue<" + valueNameFromValueId(badValueId) + ">()`;"
@@ -96,8 +318,11 @@ namespace safeconfig
       return "Invalid usage of `setValue(const " + valueNameFromValueId(badValueId) + "&)`;"
         " did you mean `setValue(const " + valueNameFromValueId(getValueId()) + "&)`?";
     }
+
+    Storage _value;
   };
 
+  // Statically typed view of a `ValueModel`; adds no state, so it can be freely sliced to a `ValueModel`
   template<ValueId id>
   class ConcreteValueModel : public ValueModel
   {
@@ -109,35 +334,22 @@ namespace safeconfig
     static_assert(!std::is_same_v<ValueType, valuetypes::UnknownType>);
 
     ConcreteValueModel()
-      : _value{}
+      : ValueModel(std::in_place_type<ValueType>, ValueType{})
     {}
 
     ConcreteValueModel(ValueType value)
-      : _value(std::move(value))
+      : ValueModel(std::in_place_type<ValueType>, std::move(value))
     {}
 
     const ValueType& getValue() const
     {
-      return _value;
+      return getValueUnchecked<ValueType>();
     }
 
     void setValue(ValueType value)
     {
-      _value = std::move(value);
-    }
-
-    virtual ValueId getValueId() const noexcept override
-    {
-      return valueId;
-    }
-
-    virtual bool operator==(const ValueModel& other) const noexcept override
-    {
-      return typeid(*this) == typeid(other) && _value == static_cast<const ConcreteValueModel&>(other)._value;
+      getValueUnchecked<ValueType>() = std::move(value);
     }
-
-  private:
-    ValueType _value;
   };
 
   inline namespace valuemodels
@@ -154,26 +366,9 @@ namespace safeconfig
       std::conditional_t<valueId == StringValueModel::valueId, StringValueModel,
       UnknownValueModel>>>;
 
-    inline std::unique_ptr<ValueModel> valueModelFromValueId(ValueId id)
+    inline ValueModel valueModelFromValueId(ValueId id)
     {
-      std::unique_ptr<ValueModel> model;
-
-      switch (id)
-      {
-      case ValueId::real:
-        model = std::make_unique<RealValueModel>();
-        break;
-      case ValueId::integer:
-        model = std::make_unique<IntegerValueModel>();
-        break;
-      case ValueId::string:
-        model = std::make_unique<StringValueModel>();
-        break;
-      default:
-        throw std::runtime_error("Not implemented");
-      }
-
-      return model;
+      return ValueModel(id);
     }
   }
 
@@ -186,7 +381,7 @@ namespace safeconfig
     if (valueId != getValueId())
       throw std::runtime_error(errMsgForBadGetValue(valueId));
 
-    return static_cast<const ValueModelTypeFromValueId<valueId>*>(this)->getValue();
+    return getValueUnchecked<TValueType>();
   }
 
   template<class TValueType>
@@ -198,571 +393,5270 @@ namespace safeconfig
     if (valueId != getValueId())
       throw std::runtime_error(errMsgForBadSetValue(valueId));
 
-    static_cast<ValueModelTypeFromValueId<valueId>*>(this)->setValue(value);
+    getValueUnchecked<TValueType>() = value;
   }
 
-  inline namespace constraints
+  template<class TValueType, class>
+  void ValueModel::setValue(TValueType&& value)
   {
-    enum class ConstraintId
-    {
-      numeric,
-      choice,
-      unknown
-    };
+    constexpr auto valueId = valueIdFromValueType<TValueType>;
+    static_assert(valueId != ValueId::unknown);
 
-    inline std::string constraintNameFromId(ConstraintId id)
+    if (valueId != getValueId())
+      throw std::runtime_error(errMsgForBadSetValue(valueId));
+
+    getValueUnchecked<TValueType>() = std::move(value);
+  }
+
+  // 64-bit FNV-1a over the bytes added; used to detect schema changes, not for security
+  class Digest
+  {
+  public:
+    void add(const void* data, std::size_t size) noexcept
     {
-      std::string name;
+      const auto* bytes = static_cast<const unsigned char*>(data);
 
-      switch (id)
+      for (std::size_t i = 0; i < size; ++i)
       {
-      case ConstraintId::numeric:
-        name = "NumericConstraint";
-        break;
-      case ConstraintId::choice:
-        name = "ChoiceConstraint";
-        break;
-      default:
-        throw std::runtime_error("Not implemented");
+        _state ^= bytes[i];
+        _state *= 1099511628211ull;
       }
-
-      return name;
     }
 
-    class Constraint
+    void add(std::string_view text) noexcept
     {
-    public:
-      virtual ~Constraint() = default;
-      virtual ValueId getValueId() const noexcept = 0;
-      virtual ConstraintId getConstraintId() const noexcept = 0;
-      virtual bool isValid(const ValueModel&) const noexcept = 0;
-    };
+      add(static_cast<std::uint64_t>(text.size()));
+      add(text.data(), text.size());
+    }
 
-    class NumericConstraint : public Constraint
+    template<class T, class = std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>>
+    void add(T value) noexcept
     {
-      using IntegerType = valuetypes::IntegerType;
-      using RealType = valuetypes::RealType;
+      add(&value, sizeof(value));
+    }
 
-    public:
-      NumericConstraint(IntegerType lowerBound, IntegerType upperBound)
-      {
-        setBounds(lowerBound, upperBound);
-      }
+    // Never 0, so that 0 can stand for "no digest"
+    std::uint64_t get() const noexcept
+    {
+      return _state ? _state : 1;
+    }
 
-      NumericConstraint(RealType lowerBound, RealType upperBound)
-      {
-        setBounds(lowerBound, upperBound);
-      }
+  private:
+    std::uint64_t _state = 14695981039346656037ull;
+  };
 
-      void setBounds(IntegerType lowerBound, IntegerType upperBound)
-      {
-        setBoundsImpl(lowerBound, upperBound);
-      }
+  // A string stored once per process in a shared, append-only pool. Equal strings are interned to the same
+  // address, so that comparing two `InternedString`s for equality is a pointer comparison. Interning a string
+  // that is already in the pool takes no lock and does not allocate; only adding a string locks the pool.
+  // The pool only grows, and lives until the process exits: intern strings from a bounded set, such as the names
+  // and choices declared by groups, and not values read from input.
+  class InternedString
+  {
+  public:
+    InternedString()
+      : InternedString(std::string_view())
+    {}
 
-      void setBounds(RealType lowerBound, RealType upperBound)
-      {
-        setBoundsImpl(lowerBound, upperBound);
-      }
+    explicit InternedString(std::string_view text)
+      : _string(&intern(text))
+    {}
 
-      virtual ValueId getValueId() const noexcept override
-      {
-        return _lb->getValueId();
-      }
+    const std::string& str() const noexcept
+    {
+      return *_string;
+    }
 
-      virtual ConstraintId getConstraintId() const noexcept override
-      {
-        return ConstraintId::numeric;
-      }
+    operator const std::string&() const noexcept
+    {
+      return *_string;
+    }
 
-      virtual bool isValid(const ValueModel& valueModel) const noexcept override
-      {
-        bool valid = false;
+    std::string_view view() const noexcept
+    {
+      return *_string;
+    }
 
-        const ValueId modelValueId = valueModel.getValueId();
+    bool operator==(InternedString other) const noexcept
+    {
+      return _string == other._string;
+    }
 
-        if (modelValueId == this->getValueId())
-        {
-          switch (modelValueId)
-          {
-          case valueIdFromValueType<IntegerType>:
-          {
-            auto value = valueModel.getValue<IntegerType>();
-            auto lower = _lb->getValue<IntegerType>();
-            auto upper = _ub->getValue<IntegerType>();
-            valid = value >= lower && value <= upper;
-            break;
-          }
-          case valueIdFromValueType<RealType>:
-          {
-            auto value = valueModel.getValue<RealType>();
-            auto lower = _lb->getValue<RealType>();
-            auto upper = _ub->getValue<RealType>();
-            valid = value >= lower && value <= upper;
-            break;
-          }
-          default:
-          {
-            // Pass
-          }
-          }
-        }
+    bool operator!=(InternedString other) const noexcept
+    {
+      return _string != other._string;
+    }
 
-        return valid;
-      }
+    // By content, so that orders do not depend on addresses
+    bool operator<(InternedString other) const noexcept
+    {
+      return *_string < *other._string;
+    }
 
-    private:
-      template<class T>
-      void setBoundsImpl(T lowerBound, T upperBound)
-      {
-        if (lowerBound > upperBound)
-          throw std::runtime_error("Parameter `lowerBound` cannot be greater than `upperBound`");
+    // Returns an empty optional if `text` has not been interned, without interning it
+    static std::optional<InternedString> find(std::string_view text)
+    {
+      std::optional<InternedString> interned;
 
-        constexpr ValueId effectiveValueId = valueIdFromValueType<T>;
-        static_assert(effectiveValueId != ValueId::unknown);
+      if (const std::string* string = lookup(*getPool().table.load(std::memory_order_acquire), text, hash(text)))
+        interned = InternedString(string);
 
-        using EffectiveValueModel = ValueModelTypeFromValueId<effectiveValueId>;
-        static_assert(!std::is_same_v<EffectiveValueModel, valuemodels::UnknownValueModel>);
+      return interned;
+    }
 
-        _lb = std::make_unique<EffectiveValueModel>(lowerBound);
-        _ub = std::make_unique<EffectiveValueModel>(upperBound);
+  private:
+    // Open addressing with linear probing; a slot is set at most once, from null to a string of the pool
+    struct Table
+    {
+      explicit Table(std::size_t capacity)
+        : slots(new std::atomic<const std::string*>[capacity])
+        , mask(capacity - 1)
+      {
+        for (std::size_t i = 0; i < capacity; ++i)
+          slots[i].store(nullptr, std::memory_order_relaxed);
       }
 
-      std::unique_ptr<ValueModel> _lb;
-      std::unique_ptr<ValueModel> _ub;
+      std::unique_ptr<std::atomic<const std::string*>[]> slots;
+      std::size_t mask;
+
+      // Replaced tables are kept, since readers may still be probing them
+      std::unique_ptr<Table> previous;
     };
 
-    class ChoiceConstraint : public Constraint
+    struct Pool
     {
-    public:
-      ChoiceConstraint(const std::vector<int>& validChoices)
-        : _validChoices{}
-      {
-        setValidChoicesImpl(validChoices);
-      }
+      // Read without locking; replaced by a larger table under `mutex`
+      std::atomic<Table*> table{ new Table(64) };
 
-      ChoiceConstraint(const std::vector<std::string>& validChoices)
-        : _validChoices{}
-      {
-        setValidChoicesImpl(validChoices);
-      }
+      // Serializes insertions
+      std::mutex mutex;
 
-      ChoiceConstraint(ChoiceConstraint&&) = default;
-      ChoiceConstraint& operator=(ChoiceConstraint&&) = default;
+      // A deque, so that addresses of the strings are stable
+      std::deque<std::string> strings;
+    };
 
-      void setValidChoices(const std::vector<int>& choices)
-      {
-        setValidChoicesImpl(choices);
-      }
+    explicit InternedString(const std::string* string) noexcept
+      : _string(string)
+    {}
+
+    // Never destroyed, so that interned strings stay valid during static destruction
+    static Pool& getPool()
+    {
+      static Pool* pool = new Pool();
+      return *pool;
+    }
+
+    static std::size_t hash(std::string_view text) noexcept
+    {
+      return std::hash<std::string_view>()(text);
+    }
+
+    static const std::string* lookup(const Table& table, std::string_view text, std::size_t hash) noexcept
+    {
+      for (std::size_t i = hash & table.mask; ; i = (i + 1) & table.mask)
+      {
+        const std::string* string = table.slots[i].load(std::memory_order_acquire);
+
+        if (!string || *string == text)
+          return string;
+      }
+    }
+
+    static void insert(Table& table, const std::string* string, std::size_t hash) noexcept
+    {
+      std::size_t i = hash & table.mask;
+
+      while (table.slots[i].load(std::memory_order_relaxed))
+        i = (i + 1) & table.mask;
+
+      table.slots[i].store(string, std::memory_order_release);
+    }
+
+    // A string that is already interned is found without locking or allocating
+    static const std::string& intern(std::string_view text)
+    {
+      Pool& pool = getPool();
+      std::size_t textHash = hash(text);
+
+      if (const std::string* string = lookup(*pool.table.load(std::memory_order_acquire), text, textHash))
+        return *string;
+
+      std::lock_guard<std::mutex> lock(pool.mutex);
+
+      // Only insertions replace the table, so it is current while the lock is held
+      Table* table = pool.table.load(std::memory_order_relaxed);
+
+      if (const std::string* string = lookup(*table, text, textHash))
+        return *string;
+
+      // At most half full, so that probes stay short and always end at a null slot
+      if (2 * (pool.strings.size() + 1) > table->mask + 1)
+      {
+        auto larger = std::make_unique<Table>(2 * (table->mask + 1));
+
+        for (const std::string& string : pool.strings)
+          insert(*larger, &string, hash(string));
+
+        larger->previous.reset(table);
+        table = larger.release();
+        pool.table.store(table, std::memory_order_release);
+      }
+
+      const std::string& string = pool.strings.emplace_back(text);
+      insert(*table, &string, textHash);
+
+      return string;
+    }
+
+    const std::string* _string;
+  };
+
+  // For building configurations from a `std::pmr::memory_resource`, e.g. one arena per configuration. The
+  // resource has to outlive every object allocated from it, including any `std::shared_ptr` handed out.
+  inline namespace allocation
+  {
+    // Deletes an object allocated by `allocateUnique`, or by `new` if no resource is set
+    class ResourceDeleter
+    {
+    public:
+      ResourceDeleter() noexcept = default;
+
+      ResourceDeleter(std::pmr::memory_resource* resource, std::size_t size, std::size_t alignment) noexcept
+        : _resource(resource)
+        , _size(size)
+        , _alignment(alignment)
+      {}
+
+      // `T` may be a base class of the allocated object if it has a virtual destructor
+      template<class T>
+      void operator()(T* object) const noexcept
+      {
+        if (!_resource)
+        {
+          delete object;
+          return;
+        }
+
+        // The address of the complete object, which is the one allocated
+        void* address = object;
+
+        if constexpr (std::is_polymorphic_v<T>)
+          address = dynamic_cast<void*>(object);
+
+        object->~T();
+        _resource->deallocate(address, _size, _alignment);
+      }
+
+    private:
+      std::pmr::memory_resource* _resource = nullptr;
+      std::size_t _size = 0;
+      std::size_t _alignment = 0;
+    };
+
+    template<class T>
+    using ResourcePtr = std::unique_ptr<T, ResourceDeleter>;
+
+    template<class T, class... Args>
+    ResourcePtr<T> allocateUnique(std::pmr::memory_resource* resource, Args&&... args)
+    {
+      void* address = resource->allocate(sizeof(T), alignof(T));
+
+      try
+      {
+        return ResourcePtr<T>(::new (address) T(std::forward<Args>(args)...),
+          ResourceDeleter(resource, sizeof(T), alignof(T)));
+      }
+      catch (...)
+      {
+        resource->deallocate(address, sizeof(T), alignof(T));
+        throw;
+      }
+    }
+
+    // The object and its reference count share a single allocation from `resource`
+    template<class T, class... Args>
+    std::shared_ptr<T> allocateShared(std::pmr::memory_resource* resource, Args&&... args)
+    {
+      return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(resource), std::forward<Args>(args)...);
+    }
+  }
+
+  inline namespace constraints
+  {
+    enum class ConstraintId
+    {
+      numeric,
+      choice,
+      unknown
+    };
+
+    inline std::string constraintNameFromId(ConstraintId id)
+    {
+      std::string name;
+
+      switch (id)
+      {
+      case ConstraintId::numeric:
+        name = "NumericConstraint";
+        break;
+      case ConstraintId::choice:
+        name = "ChoiceConstraint";
+        break;
+      default:
+        throw std::runtime_error("Not implemented");
+      }
+
+      return name;
+    }
+
+    // Constraints are immutable once constructed, so one constraint can be shared by many properties, each of
+    // which caches whether its value satisfies it. To change a constraint, give the properties a new one.
+    class Constraint
+    {
+    public:
+      virtual ~Constraint() = default;
+      Constraint& operator=(const Constraint&) = delete;
+      virtual ValueId getValueId() const noexcept = 0;
+      virtual ConstraintId getConstraintId() const noexcept = 0;
+      virtual bool isValid(const ValueModel&) const noexcept = 0;
+
+      // Checks a string value without requiring a `ValueModel` for it. The default implementation constructs one,
+      // which copies `value`; constraints on strings should override it.
+      virtual bool isValid(std::string_view value) const
+      {
+        return isValid(ValueModel(StringValueModel(StringType(value))));
+      }
+
+      // Identifies the parameters of this constraint, such that constraints with equal digests accept the same
+      // values; 0 if not supported, in which case nothing may be inferred from it
+      virtual std::uint64_t getDigest() const noexcept
+      {
+        return 0;
+      }
+
+    protected:
+      Constraint() = default;
+      Constraint(const Constraint&) = default;
+    };
+
+    // Shared constraints are taken only through pointers to const, so that no caller is left with a mutable alias
+    template<class TShared, class TConstraint>
+    inline constexpr bool isSharedConstraint = std::is_same_v<std::decay_t<TShared>, std::shared_ptr<const TConstraint>>;
+
+    template<class T>
+    std::uint64_t numericDigest(T lowerBound, T upperBound) noexcept
+    {
+      Digest digest;
+      digest.add(ConstraintId::numeric);
+      digest.add(valueIdFromValueType<T>);
+      digest.add(lowerBound);
+      digest.add(upperBound);
+
+      return digest.get();
+    }
+
+    class NumericConstraint : public Constraint
+    {
+      using IntegerType = valuetypes::IntegerType;
+      using RealType = valuetypes::RealType;
+
+    public:
+      NumericConstraint(IntegerType lowerBound, IntegerType upperBound)
+      {
+        setBounds(lowerBound, upperBound);
+      }
+
+      NumericConstraint(RealType lowerBound, RealType upperBound)
+      {
+        setBounds(lowerBound, upperBound);
+      }
+
+      virtual ValueId getValueId() const noexcept override
+      {
+        return _lb.getValueId();
+      }
+
+      virtual ConstraintId getConstraintId() const noexcept override
+      {
+        return ConstraintId::numeric;
+      }
+
+      virtual bool isValid(const ValueModel& valueModel) const noexcept override
+      {
+        bool valid = false;
+
+        const ValueId modelValueId = valueModel.getValueId();
+
+        if (modelValueId == this->getValueId())
+        {
+          switch (modelValueId)
+          {
+          case valueIdFromValueType<IntegerType>:
+          {
+            auto value = valueModel.getValueUnchecked<IntegerType>();
+            auto lower = _lb.getValueUnchecked<IntegerType>();
+            auto upper = _ub.getValueUnchecked<IntegerType>();
+            valid = value >= lower && value <= upper;
+            break;
+          }
+          case valueIdFromValueType<RealType>:
+          {
+            auto value = valueModel.getValueUnchecked<RealType>();
+            auto lower = _lb.getValueUnchecked<RealType>();
+            auto upper = _ub.getValueUnchecked<RealType>();
+            valid = value >= lower && value <= upper;
+            break;
+          }
+          default:
+          {
+            // Pass
+          }
+          }
+        }
+
+        return valid;
+      }
+
+      virtual std::uint64_t getDigest() const noexcept override
+      {
+        return _digest;
+      }
+
+      // Throws unless `T` is the value type of the bounds
+      template<class T>
+      T getLowerBound() const
+      {
+        return _lb.getValue<T>();
+      }
+
+      template<class T>
+      T getUpperBound() const
+      {
+        return _ub.getValue<T>();
+      }
+
+    private:
+      template<class T>
+      void setBounds(T lowerBound, T upperBound)
+      {
+        if (lowerBound > upperBound)
+          throw std::runtime_error("Parameter `lowerBound` cannot be greater than `upperBound`");
+
+        constexpr ValueId effectiveValueId = valueIdFromValueType<T>;
+        static_assert(effectiveValueId != ValueId::unknown);
+
+        using EffectiveValueModel = ValueModelTypeFromValueId<effectiveValueId>;
+        static_assert(!std::is_same_v<EffectiveValueModel, valuemodels::UnknownValueModel>);
+
+        _lb = EffectiveValueModel(lowerBound);
+        _ub = EffectiveValueModel(upperBound);
+        _digest = numericDigest(lowerBound, upperBound);
+      }
+
+      ValueModel _lb{ ValueId::integer };
+      ValueModel _ub{ ValueId::integer };
+      std::uint64_t _digest = 0;
+    };
+
+    // Membership lookup over a set of valid choices; the representation is picked from the choices themselves
+    template<class T>
+    class ChoiceLookup;
+
+    template<>
+    class ChoiceLookup<IntegerType>
+    {
+    public:
+      explicit ChoiceLookup(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : _sorted(resource)
+        , _bits(resource)
+      {}
+
+      ChoiceLookup(const ChoiceLookup& other, std::pmr::memory_resource* resource)
+        : _sorted(other._sorted, resource)
+        , _bits(other._bits, resource)
+        , _min(other._min)
+        , _span(other._span)
+      {}
+
+      void assign(const std::vector<IntegerType>& choices)
+      {
+        _sorted.assign(choices.cbegin(), choices.cend());
+        std::sort(_sorted.begin(), _sorted.end());
+        _sorted.erase(std::unique(_sorted.begin(), _sorted.end()), _sorted.end());
+
+        _min = _sorted.front();
+        _span = static_cast<std::uint64_t>(static_cast<std::int64_t>(_sorted.back()) - _min) + 1;
+        _bits.clear();
+
+        // A bitset is used when it costs at most one 64-bit word per choice (or is small anyway)
+        if (_span <= std::max<std::uint64_t>(minDenseSpan, 64 * _sorted.size()))
+        {
+          _bits.assign(static_cast<std::size_t>((_span + 63) / 64), 0);
+
+          for (auto choice : _sorted)
+          {
+            auto offset = static_cast<std::uint64_t>(static_cast<std::int64_t>(choice) - _min);
+            _bits[offset / 64] |= std::uint64_t{ 1 } << (offset % 64);
+          }
+        }
+      }
+
+      bool contains(IntegerType value) const noexcept
+      {
+        if (!_bits.empty())
+        {
+          auto offset = static_cast<std::uint64_t>(static_cast<std::int64_t>(value) - _min);
+          return offset < _span && ((_bits[offset / 64] >> (offset % 64)) & 1);
+        }
+
+        return std::binary_search(_sorted.cbegin(), _sorted.cend(), value);
+      }
+
+      bool isDense() const noexcept
+      {
+        return !_bits.empty();
+      }
+
+      void clear() noexcept
+      {
+        _sorted.clear();
+        _bits.clear();
+        _min = 0;
+        _span = 0;
+      }
+
+      // Sorted and without duplicates
+      const std::pmr::vector<IntegerType>& getChoices() const noexcept
+      {
+        return _sorted;
+      }
+
+    private:
+      static constexpr std::uint64_t minDenseSpan = 512;
+
+      std::pmr::vector<IntegerType> _sorted;
+      std::pmr::vector<std::uint64_t> _bits;
+      std::int64_t _min = 0;
+      std::uint64_t _span = 0;
+    };
+
+    // Choices are interned, so that constraints with the same choices share their strings
+    template<>
+    class ChoiceLookup<StringType>
+    {
+    public:
+      explicit ChoiceLookup(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : _sorted(resource)
+      {}
+
+      ChoiceLookup(const ChoiceLookup& other, std::pmr::memory_resource* resource)
+        : _sorted(other._sorted, resource)
+      {}
+
+      void assign(const std::vector<StringType>& choices)
+      {
+        _sorted.clear();
+        _sorted.reserve(choices.size());
+
+        for (const StringType& choice : choices)
+          _sorted.emplace_back(choice);
+
+        std::sort(_sorted.begin(), _sorted.end());
+        _sorted.erase(std::unique(_sorted.begin(), _sorted.end()), _sorted.end());
+      }
+
+      bool contains(std::string_view value) const noexcept
+      {
+        // For a handful of choices a linear scan (which rejects on length first) beats a binary search
+        if (_sorted.size() <= maxLinearScanSize)
+        {
+          return std::any_of(_sorted.cbegin(), _sorted.cend(),
+            [value](InternedString choice) { return choice.view() == value; });
+        }
+
+        return std::binary_search(_sorted.cbegin(), _sorted.cend(), value,
+          [](const auto& lhs, const auto& rhs) { return viewOf(lhs) < viewOf(rhs); });
+      }
+
+      // A pointer comparison per choice
+      bool contains(InternedString value) const noexcept
+      {
+        return std::find(_sorted.cbegin(), _sorted.cend(), value) != _sorted.cend();
+      }
+
+      void clear() noexcept
+      {
+        _sorted.clear();
+      }
+
+      // Sorted and without duplicates
+      const std::pmr::vector<InternedString>& getChoices() const noexcept
+      {
+        return _sorted;
+      }
+
+    private:
+      static constexpr std::size_t maxLinearScanSize = 8;
+
+      static std::string_view viewOf(InternedString text) noexcept
+      {
+        return text.view();
+      }
+
+      static std::string_view viewOf(std::string_view text) noexcept
+      {
+        return text;
+      }
+
+      std::pmr::vector<InternedString> _sorted;
+    };
+
+    template<class T>
+    std::uint64_t choiceDigest(const ChoiceLookup<T>& lookup) noexcept
+    {
+      Digest digest;
+      digest.add(ConstraintId::choice);
+      digest.add(valueIdFromValueType<T>);
+      digest.add(static_cast<std::uint64_t>(lookup.getChoices().size()));
+
+      for (const auto& choice : lookup.getChoices())
+      {
+        if constexpr (std::is_same_v<T, StringType>)
+          digest.add(choice.view());
+        else
+          digest.add(choice);
+      }
+
+      return digest.get();
+    }
+
+    class ChoiceConstraint : public Constraint
+    {
+    public:
+      // The choices are stored in `resource`
+      ChoiceConstraint(const std::vector<int>& validChoices, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : _integerChoices(resource)
+        , _stringChoices(resource)
+      {
+        setValidChoices(validChoices);
+      }
+
+      ChoiceConstraint(const std::vector<std::string>& validChoices, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : _integerChoices(resource)
+        , _stringChoices(resource)
+      {
+        setValidChoices(validChoices);
+      }
+
+      ChoiceConstraint(ChoiceConstraint&&) = default;
+
+      virtual ValueId getValueId() const noexcept override
+      {
+        return _valueId;
+      }
+
+      virtual ConstraintId getConstraintId() const noexcept override
+      {
+        return ConstraintId::choice;
+      }
+
+      virtual bool isValid(const ValueModel& valueModel) const noexcept override
+      {
+        bool valid = false;
+
+        const ValueId modelValueId = valueModel.getValueId();
+
+        if (modelValueId == _valueId)
+        {
+          switch (modelValueId)
+          {
+          case valueIdFromValueType<IntegerType>:
+            valid = _integerChoices.contains(valueModel.getValueUnchecked<IntegerType>());
+            break;
+          case valueIdFromValueType<StringType>:
+            valid = _stringChoices.contains(valueModel.getValueUnchecked<StringType>());
+            break;
+          default:
+          {
+            // Pass
+          }
+          }
+        }
+
+        return valid;
+      }
+
+      // For checking a candidate value without constructing a `ValueModel` for it
+      bool isValid(IntegerType value) const noexcept
+      {
+        return _valueId == ValueId::integer && _integerChoices.contains(value);
+      }
+
+      virtual bool isValid(std::string_view value) const noexcept override
+      {
+        return _valueId == ValueId::string && _stringChoices.contains(value);
+      }
+
+      // Sorted and without duplicates; empty unless `getValueId()` is `ValueId::integer`
+      const std::pmr::vector<IntegerType>& getIntegerChoices() const noexcept
+      {
+        return _integerChoices.getChoices();
+      }
+
+      // Sorted and without duplicates; empty unless `getValueId()` is `ValueId::string`
+      const std::pmr::vector<InternedString>& getStringChoices() const noexcept
+      {
+        return _stringChoices.getChoices();
+      }
+
+      virtual std::uint64_t getDigest() const noexcept override
+      {
+        return _digest;
+      }
+
+    private:
+      template<class T>
+      void setValidChoices(const std::vector<T>& choices)
+      {
+        constexpr ValueId effectiveValueId = valueIdFromValueType<T>;
+        static_assert(effectiveValueId != ValueId::unknown);
+
+        if (choices.empty())
+          throw std::runtime_error("Parameter `choices` cannot be an empty vector");
+
+        // The choices of the other value type are cleared, as the getters promise
+        if constexpr (effectiveValueId == ValueId::integer)
+        {
+          _integerChoices.assign(choices);
+          _stringChoices.clear();
+          _digest = choiceDigest(_integerChoices);
+        }
+        else
+        {
+          _stringChoices.assign(choices);
+          _integerChoices.clear();
+          _digest = choiceDigest(_stringChoices);
+        }
+
+        _valueId = effectiveValueId;
+      }
+
+      ValueId _valueId = ValueId::unknown;
+      std::uint64_t _digest = 0;
+      ChoiceLookup<IntegerType> _integerChoices;
+      ChoiceLookup<StringType> _stringChoices;
+    };
+
+    // Counterpart of `NumericConstraint` for a value type known at compile time; `isValid(const T&)` is a
+    // plain, inlinable range check
+    template<class T>
+    class TypedNumericConstraint : public Constraint
+    {
+      static_assert(valueIdFromValueType<T> == ValueId::integer || valueIdFromValueType<T> == ValueId::real);
+
+    public:
+      using ValueType = T;
+
+      TypedNumericConstraint(T lowerBound, T upperBound)
+        : _lb(lowerBound)
+        , _ub(upperBound)
+        , _digest(numericDigest(lowerBound, upperBound))
+      {
+        if (lowerBound > upperBound)
+          throw std::runtime_error("Parameter `lowerBound` cannot be greater than `upperBound`");
+      }
+
+      // Holds nothing that is allocated; for symmetry with `TypedChoiceConstraint`
+      TypedNumericConstraint(const TypedNumericConstraint& other, std::pmr::memory_resource* resource) noexcept
+        : TypedNumericConstraint(other)
+      {
+        static_cast<void>(resource);
+      }
+
+      virtual ValueId getValueId() const noexcept override
+      {
+        return valueIdFromValueType<T>;
+      }
+
+      virtual ConstraintId getConstraintId() const noexcept override
+      {
+        return ConstraintId::numeric;
+      }
+
+      virtual bool isValid(const ValueModel& valueModel) const noexcept override
+      {
+        return valueModel.getValueId() == valueIdFromValueType<T> && isValid(valueModel.getValueUnchecked<T>());
+      }
+
+      bool isValid(const T& value) const noexcept
+      {
+        return value >= _lb && value <= _ub;
+      }
+
+      T getLowerBound() const noexcept
+      {
+        return _lb;
+      }
+
+      T getUpperBound() const noexcept
+      {
+        return _ub;
+      }
+
+      // Equal to that of a `NumericConstraint` with the same bounds
+      virtual std::uint64_t getDigest() const noexcept override
+      {
+        return _digest;
+      }
+
+    private:
+      T _lb;
+      T _ub;
+      std::uint64_t _digest;
+    };
+
+    // Counterpart of `ChoiceConstraint` for a value type known at compile time
+    template<class T>
+    class TypedChoiceConstraint : public Constraint
+    {
+      static_assert(valueIdFromValueType<T> == ValueId::integer || valueIdFromValueType<T> == ValueId::string);
+
+    public:
+      using ValueType = T;
+
+      // The choices are stored in `resource`
+      TypedChoiceConstraint(const std::vector<T>& validChoices, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : _validChoices(resource)
+      {
+        if (validChoices.empty())
+          throw std::runtime_error("Parameter `choices` cannot be an empty vector");
+
+        _validChoices.assign(validChoices);
+        _digest = choiceDigest(_validChoices);
+      }
+
+      // A copy whose choices are stored in `resource`
+      TypedChoiceConstraint(const TypedChoiceConstraint& other, std::pmr::memory_resource* resource)
+        : _validChoices(other._validChoices, resource)
+        , _digest(other._digest)
+      {}
+
+      virtual ValueId getValueId() const noexcept override
+      {
+        return valueIdFromValueType<T>;
+      }
+
+      virtual ConstraintId getConstraintId() const noexcept override
+      {
+        return ConstraintId::choice;
+      }
+
+      virtual bool isValid(const ValueModel& valueModel) const noexcept override
+      {
+        return valueModel.getValueId() == valueIdFromValueType<T> && isValid(valueModel.getValueUnchecked<T>());
+      }
+
+      bool isValid(const T& value) const noexcept
+      {
+        return _validChoices.contains(value);
+      }
+
+      virtual bool isValid(std::string_view value) const noexcept override
+      {
+        if constexpr (std::is_same_v<T, StringType>)
+          return _validChoices.contains(value);
+        else
+          return false;
+      }
+
+      // Sorted and without duplicates; interned strings for a `StringType`
+      const auto& getChoices() const noexcept
+      {
+        return _validChoices.getChoices();
+      }
+
+      // Equal to that of a `ChoiceConstraint` with the same choices
+      virtual std::uint64_t getDigest() const noexcept override
+      {
+        return _digest;
+      }
+
+    private:
+      ChoiceLookup<T> _validChoices;
+      std::uint64_t _digest;
+    };
+  }
+
+  class Property;
+
+  // Notified by the setters of a property once they assigned a valid value; see `Property::setObserver`
+  class PropertyObserver
+  {
+  public:
+    virtual ~PropertyObserver() = default;
+
+    virtual void onValueSet(Property& property) = 0;
+  };
+
+  class Property
+  {
+  public:
+    // Constraints are immutable, so one constraint can be shared by many properties.
+    // Subclasses allocate the constraints they create from `resource`. A string value that does not fit the
+    // small-string buffer of `StringType` is allocated from the global heap.
+    Property(std::string_view name, std::shared_ptr<const Constraint> constraint,
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : _name(name)
+      , _resource(resource)
+      , _constraint(checkNotNull(std::move(constraint)))
+      , _valueModel(valueModelFromValueId(_constraint->getValueId()))
+      , _isValid(_constraint->isValid(_valueModel))
+    {
+    }
+
+    virtual ~Property() = default;
+
+    Property(Property&&) = default;
+    Property& operator=(Property&&) = default;
+
+    const std::string& getName() const noexcept
+    {
+      return _name;
+    }
+
+    // Equal for all properties of the same name
+    InternedString getInternedName() const noexcept
+    {
+      return _name;
+    }
+
+    // `T` may also be `std::string_view`, for a view of a string value
+    template<class T>
+    decltype(auto) getValue() const
+    {
+      SAFECONFIG_INSTRUMENT(_counters.reads.add());
+
+      if (!_isValid)
+        throwInvalidValue();
+
+      if constexpr (std::is_same_v<T, std::string_view>)
+        return std::string_view(_valueModel.getValue<StringType>());
+      else
+        return _valueModel.getValue<T>();
+    }
+
+    template<class T>
+    void setValue(const T& value)
+    {
+      SAFECONFIG_INSTRUMENT(_counters.writes.add());
+      _valueModel.setValue(value);
+      validateValue();
+      notifyObserver();
+    }
+
+    // Moves `value` into the property, e.g. a string just read from json
+    template<class T, class = EnableIfRvalue<T>>
+    void setValue(T&& value)
+    {
+      SAFECONFIG_INSTRUMENT(_counters.writes.add());
+      _valueModel.setValue(std::move(value));
+      validateValue();
+      notifyObserver();
+    }
+
+    const ValueModel& getValueModel() const noexcept
+    {
+      return _valueModel;
+    }
+
+    // Like `setValue`, for a value whose type is only known at run time; it must match `getValueId()`
+    void setValueModel(ValueModel value)
+    {
+      if (value.getValueId() != getValueId())
+      {
+        throw std::runtime_error("Cannot set a value of type `" + valueNameFromValueId(value.getValueId())
+          + "` for property named \"" + _name.str() + "\" of type `" + valueNameFromValueId(getValueId()) + '`');
+      }
+
+      SAFECONFIG_INSTRUMENT(_counters.writes.add());
+      _valueModel = std::move(value);
+      validateValue();
+      notifyObserver();
+    }
+
+    // For restoring a value whose validity is known, e.g. from a snapshot taken with the same constraint or from
+    // a backup of this property; requires `value.getValueId() == getValueId()`, and neither is checked
+    void setValueModelUnchecked(ValueModel value, bool isValid = true) noexcept
+    {
+      _valueModel = std::move(value);
+      _isValid = isValid;
+    }
+
+    // Whether the current value passes the current constraint (cached; no constraint check is run)
+    bool isValid() const noexcept
+    {
+      return _isValid;
+    }
+
+    // At most one observer, notified by `setValue` and `setValueModel` after they assigned a valid value, but not by
+    // `setValueModelUnchecked`; a nullptr for none, which is all an unobserved setter pays for. Set by
+    // `ChangeDispatcher` for the properties it watches; `observer` must outlive its registration, and neither may be
+    // changed concurrently with a setter.
+    void setObserver(PropertyObserver* observer) noexcept
+    {
+      _observer = observer;
+    }
+
+    PropertyObserver* getObserver() const noexcept
+    {
+      return _observer;
+    }
+
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+    const PropertyCounters& getCounters() const noexcept
+    {
+      return _counters;
+    }
+#endif
+
+    // Whether `value` would pass the current constraint; does not modify this property
+    bool accepts(const ValueModel& value) const noexcept
+    {
+      return recordValidation(_constraint->isValid(value));
+    }
+
+    // Same for a string value, which the constraints of this library check without copying it
+    bool accepts(std::string_view value) const
+    {
+      return recordValidation(getValueId() == ValueId::string && _constraint->isValid(value));
+    }
+
+    void setConstraint(std::shared_ptr<const Constraint> constraint)
+    {
+      checkNotNull(constraint);
+
+      if (_constraint->getConstraintId() != constraint->getConstraintId())
+      {
+        throw std::runtime_error("Cannot set a new constraint for property named \"" + _name.str()
+          + "\"; attempted to replace a constraint of type `" + constraintNameFromId(_constraint->getConstraintId())
+          + "` with an unrelated constraint of type `" + constraintNameFromId(constraint->getConstraintId()) + '`');
+      }
+
+      checkConstraint(*constraint);
+
+      if (_constraint->getValueId() != constraint->getValueId())
+      {
+#if 1
+        _valueModel = valueModelFromValueId(constraint->getValueId());
+#else
+        throw std::runtime_error("Cannot set a new constraint for property named \"" + _name.str()
+          + "\"; attempted to replace a constraint with a value type `" + valueNameFromValueId(_constraint->getValueId())
+          + "` with a constraint with a value type `" + valueNameFromValueId(constraint->getValueId()) + '`');
+#endif
+      }
+
+      _constraint = std::move(constraint);
+      _isValid = recordValidation(_constraint->isValid(_valueModel));
+    }
+
+    const Constraint& getConstraint() const noexcept
+    {
+      return *_constraint;
+    }
+
+    std::pmr::memory_resource* getMemoryResource() const noexcept
+    {
+      return _resource;
+    }
+
+    // For sharing the constraint of this property with other properties
+    const std::shared_ptr<const Constraint>& getSharedConstraint() const noexcept
+    {
+      return _constraint;
+    }
+
+    ValueId getValueId() const noexcept
+    {
+      return _valueModel.getValueId();
+    }
+
+    // Requires `getValueId() == valueIdFromValueType<T>` and `isValid()`; neither is checked
+    template<class T>
+    const T& getValueUnchecked() const noexcept
+    {
+      return _valueModel.getValueUnchecked<T>();
+    }
+
+  protected:
+    [[noreturn]] void throwInvalidValue() const
+    {
+      throw std::runtime_error("Value of property named \"" + _name.str() + "\" is invalid");
+    }
+
+    // Called by `setConstraint` with a replacement of the same `ConstraintId`; override to throw for one that
+    // this property cannot work with
+    virtual void checkConstraint(const Constraint& constraint) const
+    {
+      static_cast<void>(constraint);
+    }
+
+    void validateValue()
+    {
+      _isValid = recordValidation(_constraint->isValid(_valueModel));
+
+      if (!_isValid)
+        throwInvalidValue();
+    }
+
+    // For the setters, once they assigned a valid value
+    void notifyObserver()
+    {
+      if (_observer)
+        _observer->onValueSet(*this);
+    }
+
+    // Returns `isValid`
+    bool recordValidation(bool isValid) const noexcept
+    {
+      SAFECONFIG_INSTRUMENT(_counters.validations.add());
+      SAFECONFIG_INSTRUMENT(if (!isValid) _counters.validationFailures.add());
+
+      return isValid;
+    }
+
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+    void recordRead() const noexcept
+    {
+      _counters.reads.add();
+    }
+#endif
+
+    // For statically typed subclasses that check the constraint themselves; requires a matching value type
+    template<class T>
+    void setValueUnchecked(T value, bool isValid)
+    {
+      SAFECONFIG_INSTRUMENT(_counters.writes.add());
+      _valueModel.setValueUnchecked(std::move(value));
+      _isValid = isValid;
+    }
+
+  private:
+    static std::shared_ptr<const Constraint> checkNotNull(std::shared_ptr<const Constraint> constraint)
+    {
+      if (!constraint)
+        throw std::runtime_error("Parameter `constraint` is a nullptr");
+
+      return constraint;
+    }
+
+    InternedString _name;
+    std::pmr::memory_resource* _resource;
+    std::shared_ptr<const Constraint> _constraint;
+    ValueModel _valueModel;
+
+    // Result of the last constraint check; refreshed whenever the value or the constraint changes
+    bool _isValid;
+
+    PropertyObserver* _observer = nullptr;
+
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+    mutable PropertyCounters _counters;
+#endif
+  };
+
+  inline namespace properties
+  {
+    class NumericProperty : public Property
+    {
+    public:
+      using ConstraintType = NumericConstraint;
+
+      NumericProperty(std::string_view name, std::pair<int, int> limits,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Property(name, allocateShared<ConstraintType>(resource, limits.first, limits.second), resource)
+      {}
+
+      NumericProperty(std::string_view name, std::pair<double, double> limits,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Property(name, allocateShared<ConstraintType>(resource, limits.first, limits.second), resource)
+      {}
+
+      // A template, so that braced bounds are not taken for a (null) pointer
+      template<class TShared, class = std::enable_if_t<isSharedConstraint<TShared, ConstraintType>>>
+      NumericProperty(std::string_view name, TShared&& constraint,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Property(name, std::shared_ptr<const ConstraintType>(std::forward<TShared>(constraint)), resource)
+      {}
+
+      // Throws unless the matching constructor was used
+      void setConstraint(int lowerBound, int upperBound)
+      {
+        Property::setConstraint(allocateShared<ConstraintType>(getMemoryResource(), lowerBound, upperBound));
+      }
+
+      // Throws unless the matching constructor was used
+      void setConstraint(double lowerBound, double upperBound)
+      {
+        Property::setConstraint(allocateShared<ConstraintType>(getMemoryResource(), lowerBound, upperBound));
+      }
+
+      template<class TShared, class = std::enable_if_t<isSharedConstraint<TShared, ConstraintType>>>
+      void setConstraint(TShared&& constraint)
+      {
+        Property::setConstraint(std::shared_ptr<const ConstraintType>(std::forward<TShared>(constraint)));
+      }
+    };
+
+    class ChoiceProperty : public Property
+    {
+    public:
+      using ConstraintType = ChoiceConstraint;
+
+      ChoiceProperty(std::string_view name, const std::vector<int>& choices,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Property(name, allocateShared<ConstraintType>(resource, choices, resource), resource)
+      {}
+
+      ChoiceProperty(std::string_view name, const std::vector<std::string>& choices,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Property(name, allocateShared<ConstraintType>(resource, choices, resource), resource)
+      {}
+
+      template<class TShared, class = std::enable_if_t<isSharedConstraint<TShared, ConstraintType>>>
+      ChoiceProperty(std::string_view name, TShared&& constraint,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Property(name, std::shared_ptr<const ConstraintType>(std::forward<TShared>(constraint)), resource)
+      {}
+
+      // Throws unless the matching constructor was used
+      void setConstraint(const std::vector<int>& choices)
+      {
+        Property::setConstraint(allocateShared<ConstraintType>(getMemoryResource(), choices, getMemoryResource()));
+      }
+
+      // Throws unless the matching constructor was used
+      void setConstraint(const std::vector<std::string>& choices)
+      {
+        Property::setConstraint(allocateShared<ConstraintType>(getMemoryResource(), choices, getMemoryResource()));
+      }
+
+      template<class TShared, class = std::enable_if_t<isSharedConstraint<TShared, ConstraintType>>>
+      void setConstraint(TShared&& constraint)
+      {
+        Property::setConstraint(std::shared_ptr<const ConstraintType>(std::forward<TShared>(constraint)));
+      }
+    };
+
+    // Property whose value type and constraint class are known at compile time. Reading and writing through
+    // `getValue()` and `setValue(T)` involves neither a `ValueId` check nor a virtual constraint call. It is
+    // still a `Property`, so it can be exposed by a group and read from or written to json like any other,
+    // e.g. `property.setValue(json.at(property.getName()))`.
+    template<class T, class TConstraint>
+    class TypedProperty : public Property
+    {
+      static_assert(std::is_base_of_v<Constraint, TConstraint>);
+      static_assert(std::is_same_v<typename TConstraint::ValueType, T>);
+
+    public:
+      using ValueType = T;
+      using ConstraintType = TConstraint;
+
+      // Stores a copy of `constraint` in `resource`
+      TypedProperty(std::string_view name, const TConstraint& constraint,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Property(name, allocateShared<TConstraint>(resource, constraint, resource), resource)
+      {}
+
+      // A template, so that a braced `TConstraint` initializer is not taken for a (null) pointer
+      template<class TShared, class = std::enable_if_t<isSharedConstraint<TShared, TConstraint>>>
+      TypedProperty(std::string_view name, TShared&& constraint,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Property(name, std::shared_ptr<const TConstraint>(std::forward<TShared>(constraint)), resource)
+      {}
+
+      using Property::getValue;
+
+      const T& getValue() const
+      {
+        SAFECONFIG_INSTRUMENT(recordRead());
+
+        if (!isValid())
+          throwInvalidValue();
+
+        return getValueUnchecked<T>();
+      }
+
+      void setValue(T value)
+      {
+        bool valid = recordValidation(getConstraint().isValid(value));
+        setValueUnchecked(std::move(value), valid);
+
+        if (!valid)
+          throwInvalidValue();
+
+        notifyObserver();
+      }
+
+      void setConstraint(const TConstraint& constraint)
+      {
+        Property::setConstraint(allocateShared<TConstraint>(getMemoryResource(), constraint, getMemoryResource()));
+      }
+
+      template<class TShared, class = std::enable_if_t<isSharedConstraint<TShared, TConstraint>>>
+      void setConstraint(TShared&& constraint)
+      {
+        Property::setConstraint(std::shared_ptr<const TConstraint>(std::forward<TShared>(constraint)));
+      }
+
+      const TConstraint& getConstraint() const noexcept
+      {
+        return static_cast<const TConstraint&>(Property::getConstraint());
+      }
+
+    protected:
+      // `getConstraint` relies on the class of the constraint
+      void checkConstraint(const Constraint& constraint) const override
+      {
+        if (!dynamic_cast<const TConstraint*>(&constraint))
+        {
+          throw std::runtime_error("Cannot set a new constraint for property named \"" + getName()
+            + "\"; a typed property requires a constraint of its own constraint class");
+        }
+      }
+    };
+
+    template<class T>
+    using TypedNumericProperty = TypedProperty<T, TypedNumericConstraint<T>>;
+
+    template<class T>
+    using TypedChoiceProperty = TypedProperty<T, TypedChoiceConstraint<T>>;
+  }
+
+  class JsonProxy;
+
+  class JsonLike
+  {
+  public:
+    virtual ~JsonLike() = default;
+
+    virtual bool isEmpty() const = 0;
+
+    virtual operator RealType() const = 0;
+    virtual operator StringType() const = 0;
+    virtual operator IntegerType() const = 0;
+
+    virtual void operator=(const RealType& value) = 0;
+    virtual void operator=(const StringType& value) = 0;
+    virtual void operator=(const IntegerType& value) = 0;
+
+    virtual JsonProxy operator[](const std::string& key) const = 0;
+
+    // Read-only lookup; returns an empty optional if `key` does not reference a value. Unlike `operator[]`,
+    // an override must not modify the underlying json. The default implementation falls back to `operator[]`.
+    virtual std::optional<JsonProxy> find(const std::string& key) const;
+
+    bool contains(const std::string& key) const;
+
+    // Calls `visitor(key, value)` for each member of this json, if it is an object, in ascending order of the keys
+    // (as compared by `std::string::operator<`) until it returns false, and returns true; `visitor` may move `value`
+    // away. Returns false without calling `visitor` if the members cannot be enumerated in that order, as the default
+    // implementation does.
+    virtual bool forEachMember(const std::function<bool(const std::string&, JsonProxy&)>& visitor) const
+    {
+      static_cast<void>(visitor);
+      return false;
+    }
+
+    // Read-only lookup of a value that is required to exist
+    JsonProxy at(const std::string& key) const;
+
+    // Whether this json holds a value convertible to the type identified by `id`, without loss (e.g. an integer
+    // within the range of `IntegerType`); false for an empty json. The default implementation only checks that the
+    // conversion does not throw, so an adapter whose conversions are lossy should override it.
+    virtual bool holds(ValueId id) const;
+
+    // Returns the string held by this json without copying it, if the adapter can; an empty optional if this json
+    // holds no string, or if the adapter does not support it, as the default implementation does
+    virtual std::optional<std::string_view> viewString() const
+    {
+      return std::nullopt;
+    }
+
+    // Returns an empty optional unless `holds(id)`. A string is copied into the `ValueModel`.
+    std::optional<ValueModel> toValueModel(ValueId id) const;
+
+    // Whether this json holds a value of the value type of `property` that its constraint accepts; a string is
+    // checked through `viewString` if possible, so that it is not copied
+    bool isAcceptedBy(const Property& property) const;
+
+    // Whether this json holds a value equal to `value`; a string is compared through `viewString` if possible
+    bool holdsEqual(const ValueModel& value) const;
+  };
+
+  // For not having to directly deal with `std::unique_ptr<JsonLike>`. A small `JsonLike` (e.g. one holding a
+  // reference to a node of some json document) can be constructed in place, in which case no heap allocation
+  // is needed for traversing the json by means of `operator[]`.
+  class JsonProxy
+  {
+  public:
+    static constexpr std::size_t inlineStorageSize = 4 * sizeof(void*);
+
+    JsonProxy(std::unique_ptr<JsonLike> json)
+      : _json(json.release())
+      , _relocate(nullptr)
+    {
+      if (!_json)
+        throw std::runtime_error("Parameter `json` is a nullptr");
+
+      SAFECONFIG_INSTRUMENT(getJsonProxyCounters().heapAdapters.add());
+    }
+
+    // Constructs a `TJson` from `args`; stored inline if it fits `inlineStorageSize`, on the heap otherwise
+    template<class TJson, class... Args>
+    JsonProxy(std::in_place_type_t<TJson>, Args&&... args)
+      : _json(nullptr)
+      , _relocate(nullptr)
+    {
+      static_assert(std::is_base_of_v<JsonLike, TJson>);
+
+      if constexpr (isStorableInline<TJson>)
+      {
+        _json = ::new (static_cast<void*>(_storage)) TJson(std::forward<Args>(args)...);
+        _relocate = &relocate<TJson>;
+      }
+      else
+      {
+        SAFECONFIG_INSTRUMENT(getJsonProxyCounters().heapAdapters.add());
+        _json = new TJson(std::forward<Args>(args)...);
+      }
+    }
+
+    JsonProxy(JsonProxy&& other) noexcept
+      : _json(nullptr)
+      , _relocate(nullptr)
+    {
+      moveFrom(other);
+    }
+
+    JsonProxy& operator=(JsonProxy&& other) noexcept
+    {
+      if (this != &other)
+      {
+        destroy();
+        moveFrom(other);
+      }
+
+      return *this;
+    }
+
+    JsonProxy(const JsonProxy&) = delete;
+    JsonProxy& operator=(const JsonProxy&) = delete;
+
+    ~JsonProxy()
+    {
+      destroy();
+    }
+
+    JsonProxy operator[](const std::string& key)
+    {
+      return (*_json)[key];
+    }
+
+    // For accessing `JsonLike` members
+    JsonLike* operator->()
+    {
+      return _json;
+    }
+
+    // For implicit conversion
+    operator JsonLike& ()
+    {
+      return *_json;
+    }
+
+    // For implicit conversion
+    operator const JsonLike& () const
+    {
+      return *_json;
+    }
+
+    template<class T>
+    void operator=(const T& value)
+    {
+      *_json = value;
+    }
+
+    template<class T>
+    operator T() const
+    {
+      return getValue<T>();
+    }
+
+    template<class T>
+    T getValue() const
+    {
+      if (_json->isEmpty())
+        throw std::runtime_error("Expected this `JsonProxy` to reference a json that contains a value");
+
+      try
+      {
+        return static_cast<T>(*_json);
+      }
+      catch (const std::exception& exc)
+      {
+        // Catching and re-throwing here makes it easier to navigate the stack-trace in case of the exception
+        std::string msg = "Cannot convert the json value held by this `JsonProxy` to the desired type because: ";
+        msg += std::string(exc.what());
+        throw std::runtime_error(msg);
+      }
+    }
+
+  private:
+    template<class TJson>
+    static constexpr bool isStorableInline = sizeof(TJson) <= inlineStorageSize
+      && alignof(TJson) <= alignof(std::max_align_t)
+      && std::is_nothrow_move_constructible_v<TJson>;
+
+    // Moves the `TJson` referenced by `from` into the storage at `to` and returns the moved-to object
+    template<class TJson>
+    static JsonLike* relocate(void* to, JsonLike* from) noexcept
+    {
+      auto* source = static_cast<TJson*>(from);
+      JsonLike* target = ::new (to) TJson(std::move(*source));
+      source->~TJson();
+      return target;
+    }
+
+    void moveFrom(JsonProxy& other) noexcept
+    {
+      if (other._relocate)
+        _json = other._relocate(_storage, other._json);
+      else
+        _json = other._json;
+
+      _relocate = other._relocate;
+      other._json = nullptr;
+      other._relocate = nullptr;
+    }
+
+    void destroy() noexcept
+    {
+      if (_relocate)
+        _json->~JsonLike();
+      else
+        delete _json;
+
+      _json = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char _storage[inlineStorageSize];
+    JsonLike* _json;
+
+    // Set only if `_json` is stored inline
+    JsonLike* (*_relocate)(void* to, JsonLike* from) noexcept;
+  };
+
+  inline std::optional<JsonProxy> JsonLike::find(const std::string& key) const
+  {
+    std::optional<JsonProxy> json((*this)[key]);
+
+    if ((*json)->isEmpty())
+      json.reset();
+
+    return json;
+  }
+
+  inline bool JsonLike::holds(ValueId id) const
+  {
+    if (isEmpty())
+      return false;
+
+    try
+    {
+      switch (id)
+      {
+      case ValueId::real:
+        static_cast<void>(this->operator RealType());
+        return true;
+      case ValueId::integer:
+        static_cast<void>(this->operator IntegerType());
+        return true;
+      case ValueId::string:
+        static_cast<void>(this->operator StringType());
+        return true;
+      default:
+        return false;
+      }
+    }
+    catch (const std::exception&)
+    {
+      return false;
+    }
+  }
+
+  inline bool JsonLike::contains(const std::string& key) const
+  {
+    return find(key).has_value();
+  }
+
+  inline JsonProxy JsonLike::at(const std::string& key) const
+  {
+    std::optional<JsonProxy> json = find(key);
+
+    if (!json)
+      throw std::runtime_error("Expected `json[" + key + "]` to contain a value");
+
+    return std::move(*json);
+  }
+
+  inline std::optional<ValueModel> JsonLike::toValueModel(ValueId id) const
+  {
+    std::optional<ValueModel> value;
+
+    if (holds(id))
+    {
+      switch (id)
+      {
+      case ValueId::real:
+        value.emplace(RealValueModel(this->operator RealType()));
+        break;
+      case ValueId::integer:
+        value.emplace(IntegerValueModel(this->operator IntegerType()));
+        break;
+      case ValueId::string:
+        value.emplace(StringValueModel(this->operator StringType()));
+        break;
+      default:
+      {
+        // Pass
+      }
+      }
+    }
+
+    return value;
+  }
+
+  inline bool JsonLike::isAcceptedBy(const Property& property) const
+  {
+    ValueId id = property.getValueId();
+
+    if (!holds(id))
+      return false;
+
+    if (id == ValueId::string)
+    {
+      if (std::optional<std::string_view> value = viewString())
+        return property.accepts(*value);
+    }
+
+    std::optional<ValueModel> value = toValueModel(id);
+
+    return value && property.accepts(*value);
+  }
+
+  inline bool JsonLike::holdsEqual(const ValueModel& value) const
+  {
+    ValueId id = value.getValueId();
+
+    if (!holds(id))
+      return false;
+
+    if (id == ValueId::string)
+    {
+      if (std::optional<std::string_view> view = viewString())
+        return *view == value.getValueUnchecked<StringType>();
+    }
+
+    std::optional<ValueModel> held = toValueModel(id);
+
+    return held && *held == value;
+  }
+
+  // A json document held in memory, e.g. to keep what a group writes by `operator>>`, so that it can be read back
+  // by `operator<<`. Members are kept in key order, so that they can be enumerated by `forEachMember`; members must
+  // not be added while they are enumerated. Like for a `JsonTextWriter`, `operator[]` adds the member if missing.
+  class JsonTree : public JsonLike
+  {
+  public:
+    JsonTree()
+      : _nodes(1)
+    {}
+
+    JsonProxy operator[](const std::string& key) const override
+    {
+      return const_cast<JsonTree*>(this)->member(0, key);
+    }
+
+    std::optional<JsonProxy> find(const std::string& key) const override
+    {
+      return const_cast<JsonTree*>(this)->findMember(0, key);
+    }
+
+    bool forEachMember(const std::function<bool(const std::string&, JsonProxy&)>& visitor) const override
+    {
+      return const_cast<JsonTree*>(this)->visitMembers(0, visitor);
+    }
+
+    bool isEmpty() const override
+    {
+      return isEmpty(0);
+    }
+
+    bool holds(ValueId id) const override
+    {
+      return holds(0, id);
+    }
+
+    std::optional<std::string_view> viewString() const override
+    {
+      return viewString(0);
+    }
+
+    operator RealType() const override
+    {
+      return getValue<RealType>(0);
+    }
+
+    operator StringType() const override
+    {
+      return getValue<StringType>(0);
+    }
+
+    operator IntegerType() const override
+    {
+      return getValue<IntegerType>(0);
+    }
+
+    void operator=(const RealType& value) override
+    {
+      setValue(0, value);
+    }
+
+    void operator=(const StringType& value) override
+    {
+      setValue(0, value);
+    }
+
+    void operator=(const IntegerType& value) override
+    {
+      setValue(0, value);
+    }
+
+    // Equal if both hold the same values at the same keys
+    bool operator==(const JsonTree& other) const
+    {
+      return equals(0, other, 0);
+    }
+
+    bool operator!=(const JsonTree& other) const
+    {
+      return !(*this == other);
+    }
+
+    void clear()
+    {
+      _nodes.assign(1, Node());
+    }
+
+  private:
+    // A node of a tree, by index, so that it stays valid as nodes are added
+    class Cursor : public JsonLike
+    {
+    public:
+      Cursor(JsonTree& tree, std::size_t index) noexcept
+        : _tree(&tree)
+        , _index(index)
+      {}
+
+      JsonProxy operator[](const std::string& key) const override
+      {
+        return _tree->member(_index, key);
+      }
+
+      std::optional<JsonProxy> find(const std::string& key) const override
+      {
+        return _tree->findMember(_index, key);
+      }
+
+      bool forEachMember(const std::function<bool(const std::string&, JsonProxy&)>& visitor) const override
+      {
+        return _tree->visitMembers(_index, visitor);
+      }
+
+      bool isEmpty() const override
+      {
+        return _tree->isEmpty(_index);
+      }
+
+      bool holds(ValueId id) const override
+      {
+        return _tree->holds(_index, id);
+      }
+
+      std::optional<std::string_view> viewString() const override
+      {
+        return _tree->viewString(_index);
+      }
+
+      operator RealType() const override
+      {
+        return _tree->getValue<RealType>(_index);
+      }
+
+      operator StringType() const override
+      {
+        return _tree->getValue<StringType>(_index);
+      }
+
+      operator IntegerType() const override
+      {
+        return _tree->getValue<IntegerType>(_index);
+      }
+
+      void operator=(const RealType& value) override
+      {
+        _tree->setValue(_index, value);
+      }
+
+      void operator=(const StringType& value) override
+      {
+        _tree->setValue(_index, value);
+      }
+
+      void operator=(const IntegerType& value) override
+      {
+        _tree->setValue(_index, value);
+      }
+
+    private:
+      JsonTree* _tree;
+      std::size_t _index;
+    };
+
+    // Either holds a value, or members (indices of nodes) sorted by key, or neither
+    struct Node
+    {
+      std::string key;
+      std::optional<ValueModel> value;
+      std::vector<std::size_t> members;
+    };
+
+    // Returns the position in the members of `index` where a member named `key` is or belongs
+    std::vector<std::size_t>::const_iterator lowerBound(std::size_t index, std::string_view key) const
+    {
+      const std::vector<std::size_t>& members = _nodes[index].members;
+
+      return std::lower_bound(members.cbegin(), members.cend(), key,
+        [this](std::size_t member, std::string_view key) { return _nodes[member].key < key; });
+    }
+
+    JsonProxy member(std::size_t index, const std::string& key)
+    {
+      auto iter = lowerBound(index, key);
+
+      if (iter == _nodes[index].members.cend() || _nodes[*iter].key != key)
+      {
+        auto position = iter - _nodes[index].members.cbegin();
+        std::size_t member = _nodes.size();
+
+        _nodes.push_back({ key, std::nullopt, {} });
+        _nodes[index].value.reset();
+        iter = _nodes[index].members.insert(_nodes[index].members.cbegin() + position, member);
+      }
+
+      return { std::in_place_type<Cursor>, *this, *iter };
+    }
+
+    std::optional<JsonProxy> findMember(std::size_t index, const std::string& key)
+    {
+      std::optional<JsonProxy> json;
+
+      if (auto iter = lowerBound(index, key); iter != _nodes[index].members.cend() && _nodes[*iter].key == key
+        && !isEmpty(*iter))
+      {
+        json.emplace(std::in_place_type<Cursor>, *this, *iter);
+      }
+
+      return json;
+    }
+
+    bool visitMembers(std::size_t index, const std::function<bool(const std::string&, JsonProxy&)>& visitor)
+    {
+      for (std::size_t member : _nodes[index].members)
+      {
+        JsonProxy json(std::in_place_type<Cursor>, *this, member);
+
+        if (!visitor(_nodes[member].key, json))
+          break;
+      }
+
+      return true;
+    }
+
+    bool isEmpty(std::size_t index) const noexcept
+    {
+      return !_nodes[index].value && _nodes[index].members.empty();
+    }
+
+    bool holds(std::size_t index, ValueId id) const noexcept
+    {
+      const std::optional<ValueModel>& value = _nodes[index].value;
+
+      return value && (value->getValueId() == id || (id == ValueId::real && value->getValueId() == ValueId::integer));
+    }
+
+    std::optional<std::string_view> viewString(std::size_t index) const noexcept
+    {
+      std::optional<std::string_view> view;
+
+      if (holds(index, ValueId::string))
+        view = _nodes[index].value->getValueUnchecked<StringType>();
+
+      return view;
+    }
+
+    template<class T>
+    T getValue(std::size_t index) const
+    {
+      constexpr ValueId valueId = valueIdFromValueType<T>;
+
+      if (!holds(index, valueId))
+        throw std::runtime_error("Expected json to contain a value of type `" + valueNameFromValueId(valueId) + '`');
+
+      const ValueModel& value = *_nodes[index].value;
+
+      if constexpr (valueId == ValueId::real)
+      {
+        if (value.getValueId() == ValueId::integer)
+          return static_cast<RealType>(value.getValueUnchecked<IntegerType>());
+      }
+
+      return value.getValueUnchecked<T>();
+    }
+
+    template<class T>
+    void setValue(std::size_t index, const T& value)
+    {
+      ValueModel model = valueModelFromValueId(valueIdFromValueType<T>);
+      model.setValueUnchecked(value);
+
+      _nodes[index].value = std::move(model);
+      _nodes[index].members.clear();
+    }
+
+    bool equals(std::size_t index, const JsonTree& other, std::size_t otherIndex) const
+    {
+      const Node& node = _nodes[index];
+      const Node& otherNode = other._nodes[otherIndex];
+
+      if (node.value != otherNode.value || node.members.size() != otherNode.members.size())
+        return false;
+
+      for (std::size_t i = 0; i < node.members.size(); ++i)
+      {
+        std::size_t member = node.members[i];
+        std::size_t otherMember = otherNode.members[i];
+
+        if (_nodes[member].key != other._nodes[otherMember].key || !equals(member, other, otherMember))
+          return false;
+      }
+
+      return true;
+    }
+
+    // The root is the first node
+    std::vector<Node> _nodes;
+  };
+
+  class Group;
+
+  inline namespace validation
+  {
+    enum class ValidationErrc : std::uint8_t
+    {
+      missingValue,
+      typeMismatch,
+      invalidValue,
+
+      // Reported by `Group::collectInvariantErrors`, for a constraint that spans several properties
+      invariantViolation,
+
+      // Reported by `Transaction`, for a group that exposes no properties and so cannot be staged
+      unsupportedGroup
+    };
+
+    struct ValidationError
+    {
+      ValidationErrc code;
+
+      // Expected value type; `ValueId::unknown` if the error concerns a group rather than a value
+      ValueId valueId;
+
+      // Index of the innermost group that the error was found in (see `ValidationReport::getPath`)
+      std::uint32_t scope;
+
+      // Name of the offending property (or other keyed value); empty if the error concerns a group
+      std::string_view key;
+
+      // A nullptr unless the error concerns a `Property`
+      const Property* property;
+    };
+
+    // Errors collected by a validation pass. Errors are stored as codes that refer to the validated groups and
+    // properties, which must therefore outlive the report; paths and messages are only built on request.
+    class ValidationReport
+    {
+      static constexpr std::uint32_t noScope = std::numeric_limits<std::uint32_t>::max();
+
+    public:
+      // Restores the enclosing scope on destruction
+      class ScopeGuard
+      {
+      public:
+        ScopeGuard(const ScopeGuard&) = delete;
+        ScopeGuard& operator=(const ScopeGuard&) = delete;
+
+        ~ScopeGuard()
+        {
+          _report._currentScope = _enclosingScope;
+        }
+
+      private:
+        friend class ValidationReport;
+
+        ScopeGuard(ValidationReport& report, std::uint32_t enclosingScope) noexcept
+          : _report(report)
+          , _enclosingScope(enclosingScope)
+        {}
+
+        ValidationReport& _report;
+        std::uint32_t _enclosingScope;
+      };
+
+      bool isValid() const noexcept
+      {
+        return _errors.empty();
+      }
+
+      const std::vector<ValidationError>& getErrors() const noexcept
+      {
+        return _errors;
+      }
+
+      // Group names and the property name joined by '/', e.g. "myConfig/logging/level"
+      std::string getPath(const ValidationError& error) const;
+
+      std::string getMessage(const ValidationError& error) const;
+
+      // For `Group::collectErrors` implementations; errors added while the returned guard lives belong to `group`
+      [[nodiscard]] ScopeGuard enter(const Group& group)
+      {
+        std::uint32_t enclosingScope = _currentScope;
+
+        _scopes.push_back({ &group, enclosingScope });
+        _currentScope = static_cast<std::uint32_t>(_scopes.size() - 1);
+
+        return ScopeGuard(*this, enclosingScope);
+      }
+
+      void add(ValidationErrc code, const Property* property = nullptr)
+      {
+        if (property)
+          _errors.push_back({ code, property->getValueId(), _currentScope, property->getName(), property });
+        else
+          _errors.push_back({ code, ValueId::unknown, _currentScope, {}, nullptr });
+      }
+
+      // For values that are not held by a `Property`; `key` must outlive this report
+      void add(ValidationErrc code, std::string_view key, ValueId valueId)
+      {
+        _errors.push_back({ code, valueId, _currentScope, key, nullptr });
+      }
+
+    private:
+      struct Scope
+      {
+        const Group* group;
+        std::uint32_t parent;
+      };
+
+      std::vector<Scope> _scopes;
+      std::vector<ValidationError> _errors;
+      std::uint32_t _currentScope = noScope;
+    };
+  }
+
+  class Group
+  {
+  public:
+    Group(std::string_view name)
+      : _name(name)
+    {}
+
+    virtual ~Group() = default;
+
+  public:
+    const std::string& getName() const noexcept
+    {
+      return _name;
+    }
+
+    // Equal for all groups of the same name
+    InternedString getInternedName() const noexcept
+    {
+      return _name;
+    }
+
+    virtual void operator<<(const JsonLike& node) = 0;
+    virtual void operator>>(JsonLike& node) const = 0;
+
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+    GroupCounters& getCounters() const noexcept
+    {
+      return _counters;
+    }
+#endif
+
+    // Calls `visitor` with each exposed property. `visitor` is wrapped by reference, so that visiting a group
+    // allocates no `std::function`.
+    template<class TVisitor>
+    void forEachProperty(TVisitor&& visitor)
+    {
+      visitProperties(std::function<void(Property&)>(std::ref(visitor)));
+    }
+
+    template<class TVisitor>
+    void forEachProperty(TVisitor&& visitor) const
+    {
+      visitProperties(std::function<void(const Property&)>(std::ref(visitor)));
+    }
+
+    // Returns a nullptr if this group exposes no property by the name `name`. Like `forEachProperty`, allocates
+    // no `std::function`; the properties after a match are only passed over.
+    Property* findProperty(std::string_view name)
+    {
+      Property* found = nullptr;
+
+      auto visitor = [name, &found](Property& property)
+        {
+          if (!found && property.getName() == name)
+            found = &property;
+        };
+
+      forEachProperty(visitor);
+
+      return found;
+    }
+
+    const Property* findProperty(std::string_view name) const
+    {
+      const Property* found = nullptr;
+
+      auto visitor = [name, &found](const Property& property)
+        {
+          if (!found && property.getName() == name)
+            found = &property;
+        };
+
+      forEachProperty(visitor);
+
+      return found;
+    }
+
+    // Compares names by address; see `InternedString`
+    Property* findProperty(InternedString name)
+    {
+      Property* found = nullptr;
+
+      auto visitor = [name, &found](Property& property)
+        {
+          if (!found && property.getInternedName() == name)
+            found = &property;
+        };
+
+      forEachProperty(visitor);
+
+      return found;
+    }
+
+    const Property* findProperty(InternedString name) const
+    {
+      const Property* found = nullptr;
+
+      auto visitor = [name, &found](const Property& property)
+        {
+          if (!found && property.getInternedName() == name)
+            found = &property;
+        };
+
+      forEachProperty(visitor);
+
+      return found;
+    }
+
+    // Checks `json` the way `operator<<` would read it, without modifying this group or throwing, and adds every
+    // problem found to `report`. The default implementation checks each exposed property against `json[name]`.
+    virtual void collectErrors(const JsonLike& json, ValidationReport& report) const
+    {
+      auto scope = report.enter(*this);
+
+      forEachProperty([&json, &report](const Property& property)
+        {
+          std::optional<JsonProxy> propertyJson = json.find(property.getName());
+
+          if (!propertyJson)
+            report.add(ValidationErrc::missingValue, &property);
+          else if (!(*propertyJson)->holds(property.getValueId()))
+            report.add(ValidationErrc::typeMismatch, &property);
+          else if (!(*propertyJson)->isAcceptedBy(property))
+            report.add(ValidationErrc::invalidValue, &property);
+        }
+      );
+    }
+
+    // Checks the current values of this group; the default implementation checks each exposed property, and then
+    // the invariants of the group
+    virtual void collectErrors(ValidationReport& report) const
+    {
+      auto scope = report.enter(*this);
+
+      forEachProperty([&report](const Property& property)
+        {
+          if (!property.isValid())
+            report.add(ValidationErrc::invalidValue, &property);
+        }
+      );
+
+      collectInvariantErrors(report);
+    }
+
+    // Override to check constraints that span several properties of this group (e.g. one value bounding another)
+    // against the current values, adding `ValidationErrc::invariantViolation` errors to `report`. It is called
+    // within the scope of this group, and by `Transaction::commit` with the staged values in place.
+    virtual void collectInvariantErrors(ValidationReport& report) const
+    {
+      static_cast<void>(report);
+    }
+
+    ValidationReport validate(const JsonLike& json) const
+    {
+      ValidationReport report;
+      collectErrors(json, report);
+      return report;
+    }
+
+    ValidationReport validate() const
+    {
+      ValidationReport report;
+      collectErrors(report);
+      return report;
+    }
+
+  protected:
+    // Override both overloads to expose the properties of this group to generic facilities, such as
+    // `PropertyHandle`; they must visit the same properties in the same order
+    virtual void visitProperties(const std::function<void(Property&)>& visitor)
+    {
+      static_cast<void>(visitor);
+    }
+
+    virtual void visitProperties(const std::function<void(const Property&)>& visitor) const
+    {
+      static_cast<void>(visitor);
+    }
+
+  private:
+    InternedString _name;
+
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+    mutable GroupCounters _counters;
+#endif
+  };
+
+  inline std::string ValidationReport::getPath(const ValidationError& error) const
+  {
+    std::vector<std::string_view> names;
+
+    if (!error.key.empty())
+      names.push_back(error.key);
+
+    for (std::uint32_t scope = error.scope; scope != noScope; scope = _scopes[scope].parent)
+      names.push_back(_scopes[scope].group->getName());
+
+    std::string path;
+
+    for (auto iter = names.crbegin(); iter != names.crend(); ++iter)
+    {
+      if (!path.empty())
+        path += '/';
+
+      path += *iter;
+    }
+
+    return path;
+  }
+
+  inline std::string ValidationReport::getMessage(const ValidationError& error) const
+  {
+    std::string msg;
+
+    switch (error.code)
+    {
+    case ValidationErrc::missingValue:
+      msg = "Expected `" + getPath(error) + "` to contain a value";
+      break;
+    case ValidationErrc::typeMismatch:
+      msg = "Expected `" + getPath(error) + "` to contain a value of type `"
+        + valueNameFromValueId(error.valueId) + '`';
+      break;
+    case ValidationErrc::invalidValue:
+      msg = "Value of `" + getPath(error) + "` is invalid";
+      break;
+    case ValidationErrc::invariantViolation:
+      msg = "Value of `" + getPath(error) + "` is inconsistent with other values of the group";
+      break;
+    case ValidationErrc::unsupportedGroup:
+      msg = "Group `" + getPath(error) + "` exposes no properties and cannot be staged";
+      break;
+    default:
+      throw std::runtime_error("Not implemented");
+    }
+
+    return msg;
+  }
+
+  // The values modified by `Configuration::update`, in the order they were applied
+  class ChangeSet
+  {
+  public:
+    struct Change
+    {
+      // Group names and the property name joined by '/', as in `ValidationReport::getPath`
+      std::string path;
+
+      Group* group;
+
+      // A nullptr if `group` was loaded as a whole
+      Property* property;
+    };
+
+    using const_iterator = std::vector<Change>::const_iterator;
+
+    bool empty() const noexcept
+    {
+      return _changes.empty();
+    }
+
+    std::size_t size() const noexcept
+    {
+      return _changes.size();
+    }
+
+    const_iterator begin() const noexcept
+    {
+      return _changes.cbegin();
+    }
+
+    const_iterator end() const noexcept
+    {
+      return _changes.cend();
+    }
+
+    // Whether the value at `path`, or any value below it, may have changed
+    bool contains(std::string_view path) const noexcept
+    {
+      return std::any_of(_changes.cbegin(), _changes.cend(), [path](const Change& change)
+        {
+          // A group loaded as a whole covers all paths below it
+          return change.path == path || isBelow(change.path, path) || (!change.property && isBelow(path, change.path));
+        }
+      );
+    }
+
+    void add(std::string path, Group& group, Property* property = nullptr)
+    {
+      _changes.push_back({ std::move(path), &group, property });
+    }
+
+  private:
+    static bool isBelow(std::string_view path, std::string_view ancestor) noexcept
+    {
+      return path.size() > ancestor.size() && path[ancestor.size()] == '/' && path.substr(0, ancestor.size()) == ancestor;
+    }
+
+    std::vector<Change> _changes;
+  };
+
+  class Configuration;
+
+  // Calls each subscriber at most once per `ChangeSet` that changed a value at or below its path; once attached to a
+  // configuration, it dispatches every load, update and `setValue` of that configuration by itself
+  class ChangeDispatcher
+  {
+    struct Subscriber
+    {
+      std::uint64_t id;
+      std::string path;
+      std::shared_ptr<const std::function<void(const ChangeSet&)>> callback;
+    };
+
+    using Subscribers = std::vector<Subscriber>;
+
+    struct Registry;
+
+    // Observes a property for the subscriptions watching it, and keeps its group alive
+    struct Watch : PropertyObserver
+    {
+      Registry* registry;
+      std::shared_ptr<Group> group;
+      std::string path;
+      std::size_t count = 0;
+
+      void onValueSet(Property& property) override
+      {
+        if (isSuspended())
+          return;
+
+        ChangeSet changes;
+        changes.add(path, *group, &property);
+        registry->dispatch(changes);
+      }
+    };
+
+    struct Registry
+    {
+      std::mutex mutex;
+      std::shared_ptr<const Subscribers> subscribers = std::make_shared<const Subscribers>();
+      std::uint64_t nextId = 0;
+
+      // The attached configuration, if any, and the properties watched by each subscription
+      Configuration* configuration = nullptr;
+      std::unordered_map<Property*, Watch> watches;
+      std::unordered_map<std::uint64_t, std::vector<Property*>> watched;
+
+      void dispatch(const ChangeSet& changes) const
+      {
+        if (changes.empty())
+          return;
+
+        auto current = std::atomic_load_explicit(&subscribers, std::memory_order_acquire);
+
+        for (const Subscriber& subscriber : *current)
+        {
+          if (changes.contains(subscriber.path))
+            (*subscriber.callback)(changes);
+        }
+      }
+
+      void remove(std::uint64_t id)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto current = std::atomic_load_explicit(&subscribers, std::memory_order_acquire);
+        auto updated = std::make_shared<Subscribers>();
+        updated->reserve(current->size());
+
+        std::copy_if(current->cbegin(), current->cend(), std::back_inserter(*updated),
+          [id](const Subscriber& subscriber) { return subscriber.id != id; });
+
+        std::atomic_store_explicit(&subscribers, std::shared_ptr<const Subscribers>(std::move(updated)),
+          std::memory_order_release);
+
+        unwatch(id);
+      }
+
+      void unwatch(std::uint64_t id) noexcept
+      {
+        auto iter = watched.find(id);
+
+        if (iter == watched.end())
+          return;
+
+        for (Property* property : iter->second)
+        {
+          auto watch = watches.find(property);
+
+          // Not found if watching it failed
+          if (watch == watches.end())
+            continue;
+
+          if (--watch->second.count == 0)
+          {
+            property->setObserver(nullptr);
+            watches.erase(watch);
+          }
+        }
+
+        watched.erase(iter);
+      }
+
+      void unwatchAll() noexcept
+      {
+        for (auto& [property, watch] : watches)
+          property->setObserver(nullptr);
+
+        watches.clear();
+        watched.clear();
+      }
+    };
+
+  public:
+    // Cancels its subscription on destruction; may outlive the dispatcher
+    class Subscription
+    {
+    public:
+      Subscription() = default;
+
+      Subscription(Subscription&& other) noexcept
+        : _registry(std::move(other._registry))
+        , _id(other._id)
+      {}
+
+      Subscription& operator=(Subscription&& other) noexcept
+      {
+        if (this != &other)
+        {
+          cancel();
+          _registry = std::move(other._registry);
+          _id = other._id;
+        }
+
+        return *this;
+      }
+
+      ~Subscription()
+      {
+        cancel();
+      }
+
+      // Dispatches that start after this returns do not call the callback; ones already running may still do
+      void cancel() noexcept
+      {
+        if (auto registry = _registry.lock())
+        {
+          try
+          {
+            registry->remove(_id);
+          }
+          catch (...)
+          {
+            // Out of memory; the subscriber stays registered until the dispatcher is destroyed
+          }
+        }
+
+        _registry.reset();
+      }
+
+    private:
+      friend class ChangeDispatcher;
+
+      Subscription(std::weak_ptr<Registry> registry, std::uint64_t id)
+        : _registry(std::move(registry))
+        , _id(id)
+      {}
+
+      std::weak_ptr<Registry> _registry;
+      std::uint64_t _id = 0;
+    };
+
+    // While one exists on a thread, the setters of properties watched by any dispatcher notify no one on that
+    // thread; for loads that dispatch what they loaded as a whole once done
+    class Suspension
+    {
+    public:
+      Suspension() noexcept
+      {
+        ++getSuspensionDepth();
+      }
+
+      ~Suspension()
+      {
+        --getSuspensionDepth();
+      }
+
+      Suspension(const Suspension&) = delete;
+      Suspension& operator=(const Suspension&) = delete;
+    };
+
+    ChangeDispatcher() = default;
+
+    // Attaches this dispatcher to `configuration`, which must outlive it and may have no other dispatcher attached
+    explicit ChangeDispatcher(Configuration& configuration);
+
+    ChangeDispatcher(const ChangeDispatcher&) = delete;
+    ChangeDispatcher& operator=(const ChangeDispatcher&) = delete;
+
+    ~ChangeDispatcher();
+
+    // `path` is a group or property path as in `ValidationReport::getPath`, e.g. "myConfig/logging" or
+    // "myConfig/logging/level". Subscribing, and cancelling, must not run concurrently with the setters of the
+    // properties watched for an attached configuration.
+    [[nodiscard]] Subscription subscribe(std::string path, std::function<void(const ChangeSet&)> callback)
+    {
+      if (!callback)
+        throw std::runtime_error("Parameter `callback` is empty");
+
+      std::lock_guard<std::mutex> lock(_registry->mutex);
+
+      auto current = std::atomic_load_explicit(&_registry->subscribers, std::memory_order_acquire);
+      auto updated = std::make_shared<Subscribers>(*current);
+      std::uint64_t id = _registry->nextId;
+
+      if (_registry->configuration)
+        watch(id, path);
+
+      try
+      {
+        updated->push_back({ id, std::move(path),
+          std::make_shared<const std::function<void(const ChangeSet&)>>(std::move(callback)) });
+      }
+      catch (...)
+      {
+        _registry->unwatch(id);
+        throw;
+      }
+
+      ++_registry->nextId;
+      std::atomic_store_explicit(&_registry->subscribers, std::shared_ptr<const Subscribers>(std::move(updated)),
+        std::memory_order_release);
+
+      return Subscription(_registry, id);
+    }
+
+    // Calls the subscribers of the paths in `changes`, in the order of subscription. An exception thrown by a
+    // callback propagates, and the remaining subscribers are not notified.
+    void dispatch(const ChangeSet& changes) const
+    {
+      _registry->dispatch(changes);
+    }
+
+    std::size_t getSubscriberCount() const noexcept
+    {
+      return std::atomic_load_explicit(&_registry->subscribers, std::memory_order_acquire)->size();
+    }
+
+    static bool isSuspended() noexcept
+    {
+      return getSuspensionDepth() != 0;
+    }
+
+  private:
+    static std::size_t& getSuspensionDepth() noexcept
+    {
+      static thread_local std::size_t depth = 0;
+      return depth;
+    }
+
+    // Observes the properties of the attached configuration at or below `path` for the subscriber `id`
+    void watch(std::uint64_t id, std::string_view path);
+
+    std::shared_ptr<Registry> _registry = std::make_shared<Registry>();
+  };
+
+  template<class>
+  struct less;
+
+  // Orders groups by name; transparent, so that groups can be looked up by name without constructing a group
+  template<template<typename> class smart_ptr>
+  struct less<smart_ptr<Group>>
+  {
+    using is_transparent = void;
+
+    bool operator()(const smart_ptr<Group>& lhs, const smart_ptr<Group>& rhs) const noexcept
+    {
+      return lhs->getName() < rhs->getName();
+    }
+
+    bool operator()(const smart_ptr<Group>& lhs, std::string_view rhs) const noexcept
+    {
+      return std::string_view(lhs->getName()) < rhs;
+    }
+
+    bool operator()(std::string_view lhs, const smart_ptr<Group>& rhs) const noexcept
+    {
+      return lhs < std::string_view(rhs->getName());
+    }
+  };
+
+  // Loads groups that expose no properties (see `Group::forEachProperty`) all or none. Such a group can only be
+  // restored through its own operators: before any group is loaded, each one writes its current state into a
+  // `JsonTree` by `operator>>`, and if loading a group fails, the groups loaded before it read that state back by
+  // `operator<<`. Restoring thus relies on a group accepting what it writes; a group that fails to read its state
+  // back is left as it is.
+  class OpaqueGroupLoader
+  {
+  public:
+    // `json` has to remain valid until `load` returns
+    void add(Group& group, const JsonLike& json)
+    {
+      _entries.push_back({ &group, &json, JsonTree() });
+    }
+
+    bool empty() const noexcept
+    {
+      return _entries.empty();
+    }
+
+    std::size_t size() const noexcept
+    {
+      return _entries.size();
+    }
+
+    // Loads the groups in the order they were added; on failure rethrows, with `getFailedIndex()` set, once the
+    // groups loaded before have been restored
+    void load();
+
+    // Restores the groups loaded by the last `load`, e.g. if what follows it fails
+    void restore() noexcept;
+
+    // Whether the group added at `index` writes the same json since `load` as it did before
+    bool isUnchanged(std::size_t index) const;
+
+    // The index of the group that failed to load, or was not backed up, during the last `load`; `size()` if none
+    std::size_t getFailedIndex() const noexcept
+    {
+      return _failedIndex;
+    }
+
+  private:
+    struct Entry
+    {
+      Group* group;
+      const JsonLike* json;
+      JsonTree backup;
+    };
+
+    std::vector<Entry> _entries;
+    std::size_t _failedIndex = 0;
+    std::size_t _loadedCount = 0;
+  };
+
+  class Configuration : public Group
+  {
+  public:
+    // Groups created by `emplace`, and the bookkeeping of all groups, are allocated from `resource`
+    Configuration(std::string_view name, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : Group(name)
+      , _groups(GroupSet::allocator_type(resource))
+    {}
+
+    std::pmr::memory_resource* getMemoryResource() const noexcept
+    {
+      return _groups.get_allocator().resource();
+    }
+
+    // Constructs a `TGroup` from `args` in the memory resource of this configuration and inserts it. If `TGroup`
+    // can be constructed from `args` followed by a `std::pmr::memory_resource*`, the resource is passed along, so
+    // that the group can allocate its properties from it too.
+    template<class TGroup, class... Args>
+    std::shared_ptr<TGroup> emplace(Args&&... args)
+    {
+      static_assert(std::is_base_of_v<Group, TGroup>);
+
+      std::shared_ptr<TGroup> group;
+
+      if constexpr (std::is_constructible_v<TGroup, Args&&..., std::pmr::memory_resource*>)
+        group = allocateShared<TGroup>(getMemoryResource(), std::forward<Args>(args)..., getMemoryResource());
+      else
+        group = allocateShared<TGroup>(getMemoryResource(), std::forward<Args>(args)...);
+
+      insert(group);
+
+      return group;
+    }
+
+    bool contains(std::string_view name) const
+    {
+      return findByName(name) != _groups.cend();
+    }
+
+    bool insert(std::shared_ptr<Group> group, bool silent = false)
+    {
+      auto [other, success] = _groups.insert(std::move(group));
+
+      if (!success && !silent)
+        throw std::runtime_error("Unable to insert `group` with name \"" + (*other)->getName()
+          + "\" because another group with the same name already exists");
+
+      return success;
+    }
+
+    std::shared_ptr<Group> remove(std::string_view name, bool silent = false)
+    {
+      std::shared_ptr<Group> group;
+
+      if (auto iter = findByName(name); iter != _groups.cend())
+      {
+        group = *iter;
+        _lazyGroups.erase(group.get());
+        _groups.erase(iter);
+      }
+      else if (!silent)
+        throw std::runtime_error("Unable to remove group by name \"" + std::string(name) + "\" because it does not exist");
+
+      return group;
+    }
+
+    template<class GroupType>
+    std::shared_ptr<GroupType> getTyped(std::string_view name, bool silent = false) const
+    {
+      std::shared_ptr<GroupType> typedGroup;
+
+      if (std::shared_ptr<Group> group = get(name, silent); group)
+        typedGroup = std::dynamic_pointer_cast<GroupType>(std::move(group));
+
+      if (!typedGroup && !silent)
+        throw std::runtime_error("Unable to get group by name \"" + std::string(name) + "\" in the specified type");
+
+      return typedGroup;
+    }
+
+    // Groups deferred by `loadLazy` are loaded before they are visited
+    void forEachGroup(const std::function<void(Group&)>& visitor)
+    {
+      for (auto& group : _groups)
+      {
+        loadIfPending(*group);
+        visitor(*group);
+      }
+    }
+
+    void forEachGroup(const std::function<void(const Group&)>& visitor) const
+    {
+      for (auto& group : _groups)
+      {
+        loadIfPending(*group);
+        visitor(*group);
+      }
+    }
+
+    // Like `forEachGroup`, but leaves groups deferred by `loadLazy` pending, e.g. for reporting on all groups
+    void forEachGroupWithoutLoading(const std::function<void(const Group&)>& visitor) const
+    {
+      for (auto& group : _groups)
+        visitor(*group);
+    }
+
+    // Loads the group first if it was deferred by `loadLazy`, and throws if that fails (even if `silent`)
+    std::shared_ptr<Group> get(std::string_view name, bool silent = false) const
+    {
+      std::shared_ptr<Group> group;
+
+      if (auto iter = findByName(name); iter != _groups.cend())
+      {
+        loadIfPending(**iter);
+        group = *iter;
+      }
+      else if (!silent)
+        throw std::runtime_error("Cannot get group by name \"" + std::string(name) + "\" because it does not exist");
+
+      return group;
+    }
+
+    // Like `get`, but leaves the group pending if it was deferred by `loadLazy`; a nullptr if there is no such group
+    std::shared_ptr<Group> getWithoutLoading(std::string_view name) const
+    {
+      auto iter = findByName(name);
+      return iter != _groups.cend() ? *iter : nullptr;
+    }
+
+    // The attached dispatcher is notified of a change of the whole configuration, also if loading fails after some
+    // groups were loaded
+    void operator<<(const JsonLike& json) override final
+    {
+      std::optional<JsonProxy> thisJson = json.find(getName());
+
+      if (!thisJson)
+        throw std::runtime_error("Expected `json[" + getName() + "]` to contain a value");
+
+      try
+      {
+        for (auto& group : _groups)
+        {
+          std::optional<JsonProxy> groupJson = (*thisJson)->find(group->getName());
+
+          if (!groupJson)
+            throw std::runtime_error("Expected `json[" + getName() + "][" + group->getName() + "]` to contain a value");
+
+          loadGroup(*group, *groupJson);
+
+          // Superseded
+          if (!_lazyGroups.empty())
+            _lazyGroups.erase(group.get());
+        }
+      }
+      catch (...)
+      {
+        notifyReloaded();
+        throw;
+      }
+
+      // Releases the document retained by `loadLazy`
+      discardLazyGroups();
+      notifyReloaded();
+    }
+
+    // Like `operator<<`, but loads the groups all or none on up to `threadCount` threads (0 for one per hardware
+    // thread); `find` and `at` of `json` must be safe to call concurrently
+    void loadParallel(const JsonLike& json, unsigned threadCount = 0)
+    {
+      std::vector<LoadTask> tasks;
+      std::deque<std::string> paths;
+      collectLoadTasks(json, {}, tasks, paths);
+
+      // Back up all exposed properties; the other groups are backed up by `loader`
+      std::vector<std::tuple<Property*, ValueModel, bool>> backup;
+      std::vector<LoadTask*> parallelTasks;
+      std::vector<LoadTask*> sequentialTasks;
+      OpaqueGroupLoader loader;
+
+      for (LoadTask& task : tasks)
+      {
+        if (!task.json)
+          continue;
+
+        bool exposesProperties = false;
+
+        auto visitor = [&](Property& property)
+          {
+            exposesProperties = true;
+            backup.emplace_back(&property, property.getValueModel(), property.isValid());
+          };
+
+        task.group->forEachProperty(visitor);
+
+        if (exposesProperties)
+        {
+          parallelTasks.push_back(&task);
+        }
+        else
+        {
+          loader.add(*task.group, *task.json);
+          sequentialTasks.push_back(&task);
+        }
+      }
+
+      auto throwErrors = [&]()
+        {
+          std::string message;
+
+          for (const LoadTask& task : tasks)
+          {
+            if (!task.error.empty())
+              message += "\n  " + task.error;
+          }
+
+          if (!message.empty())
+            throw std::runtime_error("Cannot load configuration \"" + getName() + '"' + message);
+        };
+
+      throwErrors();
+
+      std::atomic<std::size_t> next{ 0 };
+      std::atomic<bool> hasFailed{ false };
+
+      auto work = [&]()
+        {
+          // Groups are claimed one at a time, so that uneven loading costs are balanced across threads
+          for (std::size_t i = next++; i < parallelTasks.size(); i = next++)
+          {
+            LoadTask& task = *parallelTasks[i];
+
+            try
+            {
+              loadGroup(*task.group, *task.json);
+            }
+            catch (...)
+            {
+              // Nothing may escape a thread; turned into a message by `setError` on the calling thread
+              task.exception = std::current_exception();
+              hasFailed = true;
+            }
+          }
+        };
+
+      if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+      std::size_t workerCount = std::min<std::size_t>(threadCount, parallelTasks.size());
+      std::vector<std::thread> workers;
+
+      // Joins the workers however this scope is left
+      struct Joiner
+      {
+        std::vector<std::thread>& workers;
+
+        ~Joiner()
+        {
+          for (std::thread& worker : workers)
+            worker.join();
+        }
+      } joiner{ workers };
+
+      if (workerCount > 1)
+      {
+        workers.reserve(workerCount - 1);
+
+        for (std::size_t i = 1; i < workerCount; ++i)
+        {
+          try
+          {
+            workers.emplace_back(work);
+          }
+          catch (const std::system_error&)
+          {
+            // Out of threads; those started, and this one, claim the remaining groups
+            break;
+          }
+        }
+      }
+
+      work();
+
+      for (std::thread& worker : workers)
+        worker.join();
+
+      workers.clear();
+
+      for (LoadTask* task : parallelTasks)
+      {
+        if (task->exception)
+          task->setError(task->exception);
+      }
+
+      if (!hasFailed && !loader.empty())
+      {
+        try
+        {
+          loader.load();
+        }
+        catch (...)
+        {
+          sequentialTasks[loader.getFailedIndex()]->setError(std::current_exception());
+          hasFailed = true;
+        }
+      }
+
+      if (hasFailed)
+      {
+        for (auto& [property, value, isValid] : backup)
+          property->setValueModelUnchecked(std::move(value), isValid);
+
+        throwErrors();
+      }
+
+      // Superseded
+      discardLazyGroups();
+      notifyReloaded();
+    }
+
+    // Reads `json` as `operator<<` does, but all or nothing, with the guarantees of `Transaction::commit`: only the
+    // property values that differ from the current ones (as compared by `ValueModel::operator==`) are assigned, and
+    // what changed is returned. All changed values are validated before any is applied, and the invariants of the
+    // groups they belong to (see `Group::collectInvariantErrors`) are checked with them in place; on failure nothing
+    // is modified and the first error is thrown. Groups that expose no properties cannot be compared value by value;
+    // they are loaded as a whole (see `OpaqueGroupLoader`), their invariants checked too, and reported as changed if
+    // what they write by `operator>>` changed. Once applied, the changes are dispatched to the attached dispatcher,
+    // if any.
+    ChangeSet update(const JsonLike& json)
+    {
+      PendingUpdate pending;
+      ValidationReport report;
+      std::string path;
+
+      collectChanges(json, path, report, pending);
+
+      if (!report.isValid())
+        throw std::runtime_error(report.getMessage(report.getErrors().front()));
+
+      OpaqueGroupLoader loader;
+
+      for (auto& [group, groupJson, groupPath] : pending.groups)
+        loader.add(*group, groupJson);
+
+      loader.load();
+
+      ChangeSet changes;
+      std::set<const Group*> touched;
+
+      // The backup is complete before the first value is applied, so that applying cannot fail halfway
+      std::vector<std::pair<ValueModel, bool>> backup;
+
+      try
+      {
+        for (std::size_t i = 0; i < pending.groups.size(); ++i)
+        {
+          touched.insert(pending.groups[i].group);
+
+          if (!loader.isUnchanged(i))
+            changes.add(std::move(pending.groups[i].path), *pending.groups[i].group);
+        }
+
+        backup.reserve(pending.values.size());
+
+        for (auto& [group, property, value, propertyPath] : pending.values)
+        {
+          touched.insert(group);
+          changes.add(std::move(propertyPath), *group, property);
+          backup.emplace_back(property->getValueModel(), property->isValid());
+        }
+      }
+      catch (...)
+      {
+        loader.restore();
+        throw;
+      }
+
+      // Validated while collected, so that applying cannot fail
+      for (auto& [group, property, value, propertyPath] : pending.values)
+        property->setValueModelUnchecked(std::move(value));
+
+      auto restore = [&]() noexcept
+        {
+          for (std::size_t i = 0; i < pending.values.size(); ++i)
+            pending.values[i].property->setValueModelUnchecked(std::move(backup[i].first), backup[i].second);
+
+          loader.restore();
+        };
+
+      try
+      {
+        collectTouchedInvariantErrors(report, touched);
+      }
+      catch (...)
+      {
+        restore();
+        throw;
+      }
+
+      if (!report.isValid())
+      {
+        restore();
+        throw std::runtime_error(report.getMessage(report.getErrors().front()));
+      }
+
+      // All groups were loaded while collected
+      discardLazyGroups();
+
+      if (_dispatcher)
+        _dispatcher->dispatch(changes);
+
+      return changes;
+    }
+
+    // Like `operator<<`, but loads each group on first access; `json` and its document must remain unchanged until
+    // all groups are loaded (see `loadPending`)
+    void loadLazy(std::shared_ptr<const JsonLike> json)
+    {
+      if (!json)
+        throw std::runtime_error("Parameter `json` is a nullptr");
+
+      auto document = std::make_shared<LazyDocument>();
+      std::vector<LazyGroupJson> groupJsons;
+
+      collectLazyGroups(*json, {}, *document, groupJsons);
+      document->json = std::move(json);
+
+      retainLazyDocument(document);
+
+      for (auto& [configuration, group, groupJson] : groupJsons)
+        configuration->_lazyGroups.try_emplace(group).first->second.json.emplace(std::move(groupJson));
+
+      notifyReloaded();
+    }
+
+    // Loads all groups deferred by `loadLazy`, including those of nested configurations; throws on the first failure
+    void loadPending() const
+    {
+      for (auto& group : _groups)
+      {
+        loadIfPending(*group);
+
+        if (auto* configuration = dynamic_cast<const Configuration*>(group.get()))
+          configuration->loadPending();
+      }
+    }
+
+    // Drops the groups deferred by `loadLazy` without loading them, e.g. once their values were loaded otherwise
+    void discardLazyGroups()
+    {
+      _lazyGroups.clear();
+      _lazyDocument.reset();
+
+      for (auto& group : _groups)
+      {
+        if (auto* configuration = dynamic_cast<Configuration*>(group.get()))
+          configuration->discardLazyGroups();
+      }
+    }
+
+    // The dispatcher attached to this configuration, if any; see `ChangeDispatcher`
+    ChangeDispatcher* getDispatcher() const noexcept
+    {
+      return _dispatcher;
+    }
+
+    // Notifies the attached dispatcher, if any, of a change of the whole configuration, e.g. after loading it
+    void notifyReloaded()
+    {
+      if (_dispatcher)
+      {
+        ChangeSet changes;
+        changes.add(getName(), *this);
+        _dispatcher->dispatch(changes);
+      }
+    }
+
+    // Whether the group named `name` was deferred by `loadLazy` and has not been loaded yet
+    bool isPending(std::string_view name) const
+    {
+      if (auto iter = findByName(name); iter != _groups.cend())
+      {
+        if (auto lazyIter = _lazyGroups.find(iter->get()); lazyIter != _lazyGroups.cend())
+          return !lazyIter->second.isLoaded.load(std::memory_order_acquire);
+      }
+
+      return false;
+    }
+
+    void collectErrors(const JsonLike& json, ValidationReport& report) const override
+    {
+      auto scope = report.enter(*this);
+
+      std::optional<JsonProxy> thisJson = json.find(getName());
+
+      if (!thisJson)
+      {
+        report.add(ValidationErrc::missingValue);
+        return;
+      }
+
+      for (auto& group : _groups)
+      {
+        if (std::optional<JsonProxy> groupJson = (*thisJson)->find(group->getName()); groupJson)
+        {
+          group->collectErrors(*groupJson, report);
+        }
+        else
+        {
+          auto groupScope = report.enter(*group);
+          report.add(ValidationErrc::missingValue);
+        }
+      }
+    }
+
+    void collectErrors(ValidationReport& report) const override
+    {
+      auto scope = report.enter(*this);
+
+      for (auto& group : _groups)
+      {
+        if (auto lazyIter = _lazyGroups.find(group.get()); lazyIter != _lazyGroups.cend())
+        {
+          LazyGroup& lazyGroup = lazyIter->second;
+          std::lock_guard<std::mutex> lock(lazyGroup.mutex);
+
+          if (lazyGroup.json)
+          {
+            group->collectErrors(*lazyGroup.json, report);
+            continue;
+          }
+        }
+
+        group->collectErrors(report);
+      }
+    }
+
+    void operator>>(JsonLike& json) const override final
+    {
+      JsonProxy thisJson = json[getName()];
+
+      for (auto& group : _groups)
+      {
+        loadIfPending(*group);
+        JsonProxy groupJson = thisJson[group->getName()];
+
+        storeGroup(*group, groupJson);
+      }
+    }
+
+    void operator>>(JsonLike&& temporaryJsonWrapper) const
+    {
+      this->operator>>(temporaryJsonWrapper);
+    }
+
+  protected:
+    using GroupSet = std::set<std::shared_ptr<Group>, less<std::shared_ptr<Group>>,
+      std::pmr::polymorphic_allocator<std::shared_ptr<Group>>>;
+
+    GroupSet::const_iterator findByName(std::string_view name) const
+    {
+      return _groups.find(name);
+    }
+
+  private:
+    // One per group to load, in the order of the groups; a task without json only reports a missing value
+    struct LoadTask
+    {
+      Group* group;
+      std::optional<JsonProxy> json;
+
+      // That of the enclosing configuration, e.g. "[myConfig]"
+      const std::string* enclosingPath;
+
+      // Set if loading the group failed
+      std::string error;
+
+      // Set if loading the group failed on a worker thread, until turned into `error`
+      std::exception_ptr exception = nullptr;
+
+      void setError(const std::exception_ptr& exception)
+      {
+        std::string prefix = "`json" + *enclosingPath + '[' + group->getName() + "]`: ";
+
+        try
+        {
+          std::rethrow_exception(exception);
+        }
+        catch (const std::exception& exception)
+        {
+          error = prefix + exception.what();
+        }
+        catch (...)
+        {
+          error = prefix + "unknown exception";
+        }
+      }
+    };
+
+    // `paths` stores a json path (in the format of `operator<<` messages) per configuration, for the tasks to refer to
+    void collectLoadTasks(const JsonLike& json, const std::string& enclosingPath, std::vector<LoadTask>& tasks,
+      std::deque<std::string>& paths)
+    {
+      const std::string& jsonPath = paths.emplace_back(enclosingPath + '[' + getName() + ']');
+      std::optional<JsonProxy> thisJson = json.find(getName());
+
+      if (!thisJson)
+      {
+        tasks.push_back({ this, std::nullopt, &jsonPath, "Expected `json" + jsonPath + "` to contain a value" });
+        return;
+      }
+
+      for (auto& group : _groups)
+      {
+        std::optional<JsonProxy> groupJson = (*thisJson)->find(group->getName());
+
+        if (!groupJson)
+        {
+          tasks.push_back({ group.get(), std::nullopt, &jsonPath,
+            "Expected `json" + jsonPath + '[' + group->getName() + "]` to contain a value" });
+        }
+        else if (auto* configuration = dynamic_cast<Configuration*>(group.get()))
+          configuration->collectLoadTasks(*groupJson, jsonPath + '[' + group->getName() + ']', tasks, paths);
+        else
+          tasks.push_back({ group.get(), std::move(groupJson), &jsonPath, {} });
+      }
+    }
+
+    struct PendingGroup
+    {
+      Group* group;
+      JsonProxy json;
+      std::string path;
+    };
+
+    struct PendingValue
+    {
+      Group* group;
+      Property* property;
+      ValueModel value;
+      std::string path;
+    };
+
+    struct PendingUpdate
+    {
+      std::vector<PendingGroup> groups;
+      std::vector<PendingValue> values;
+    };
+
+    static void appendPath(std::string& path, const std::string& name)
+    {
+      if (!path.empty())
+        path += '/';
+
+      path += name;
+    }
+
+    // `path` is that of the enclosing configuration, and is restored on return
+    void collectChanges(const JsonLike& json, std::string& path, ValidationReport& report, PendingUpdate& pending)
+    {
+      auto scope = report.enter(*this);
+
+      std::optional<JsonProxy> thisJson = json.find(getName());
+
+      if (!thisJson)
+      {
+        report.add(ValidationErrc::missingValue);
+        return;
+      }
+
+      std::size_t pathSize = path.size();
+      appendPath(path, getName());
+
+      for (auto& group : _groups)
+      {
+        // Changes are relative to the values the group would be loaded with
+        loadIfPending(*group);
+
+        std::optional<JsonProxy> groupJson = (*thisJson)->find(group->getName());
+
+        if (!groupJson)
+        {
+          auto groupScope = report.enter(*group);
+          report.add(ValidationErrc::missingValue);
+        }
+        else if (auto* configuration = dynamic_cast<Configuration*>(group.get()))
+        {
+          configuration->collectChanges(*groupJson, path, report, pending);
+        }
+        else
+        {
+          collectGroupChanges(*group, std::move(*groupJson), path, report, pending);
+        }
+      }
+
+      path.resize(pathSize);
+    }
+
+    // Checks the invariants of the groups in `groups`, within the scopes of this and the nested configurations
+    void collectTouchedInvariantErrors(ValidationReport& report, const std::set<const Group*>& groups) const
+    {
+      auto scope = report.enter(*this);
+
+      for (auto& group : _groups)
+      {
+        if (auto* configuration = dynamic_cast<const Configuration*>(group.get()))
+          configuration->collectTouchedInvariantErrors(report, groups);
+        else if (groups.count(group.get()))
+        {
+          auto groupScope = report.enter(*group);
+          group->collectInvariantErrors(report);
+        }
+      }
+    }
+
+    // `path` is that of the enclosing configuration; paths are only built for changed values
+    static void collectGroupChanges(Group& group, JsonProxy json, const std::string& path, ValidationReport& report,
+      PendingUpdate& pending)
+    {
+      bool exposesProperties = false;
+
+      {
+        auto scope = report.enter(group);
+
+        auto visitor = [&](Property& property)
+          {
+            exposesProperties = true;
+
+            std::optional<JsonProxy> propertyJson = json->find(property.getName());
+
+            if (!propertyJson)
+            {
+              report.add(ValidationErrc::missingValue, &property);
+              return;
+            }
+
+            // Only a changed value is copied
+            if (!(*propertyJson)->holds(property.getValueId()))
+            {
+              report.add(ValidationErrc::typeMismatch, &property);
+            }
+            else if ((*propertyJson)->holdsEqual(property.getValueModel()))
+            {
+              if (!property.isValid())
+                report.add(ValidationErrc::invalidValue, &property);
+            }
+            else if (!(*propertyJson)->isAcceptedBy(property))
+            {
+              report.add(ValidationErrc::invalidValue, &property);
+            }
+            else
+            {
+              pending.values.push_back({ &group, &property, *(*propertyJson)->toValueModel(property.getValueId()),
+                path + '/' + group.getName() + '/' + property.getName() });
+            }
+          };
+
+        group.forEachProperty(visitor);
+      }
+
+      if (!exposesProperties)
+      {
+        group.collectErrors(json, report);
+        pending.groups.push_back({ &group, std::move(json), path + '/' + group.getName() });
+      }
+    }
+
+    // The properties set by `group` notify no one; the loads dispatch what they loaded as a whole
+    static void loadGroup(Group& group, const JsonLike& json)
+    {
+      SAFECONFIG_INSTRUMENT(LatencyRecorder recorder(group.getCounters().loads));
+      ChangeDispatcher::Suspension suspension;
+      group << json;
+    }
+
+    static void storeGroup(const Group& group, JsonLike& json)
+    {
+      SAFECONFIG_INSTRUMENT(LatencyRecorder recorder(group.getCounters().serializations));
+      group >> json;
+    }
+
+    // The retained json of a group deferred by `loadLazy`. Entries are only added or removed by non-const
+    // operations, so that concurrent accesses merely look them up.
+    struct LazyGroup
+    {
+      std::mutex mutex;
+      std::atomic<bool> isLoaded{ false };
+      std::optional<JsonProxy> json;
+    };
+
+    // The document retained by `loadLazy`, shared by a configuration and its nested configurations, with the json
+    // objects the json of their groups may refer to: that of each configuration, and the member holding it
+    struct LazyDocument
+    {
+      std::shared_ptr<const JsonLike> json;
+      std::deque<JsonProxy> enclosingJson;
+    };
+
+    struct LazyGroupJson
+    {
+      Configuration* configuration;
+      const Group* group;
+      JsonProxy json;
+    };
+
+    // Checks that `json` holds a value for each group of this configuration and of its nested configurations, and
+    // collects the json of the groups to be deferred; `enclosingPath` is that of `json`, for messages
+    void collectLazyGroups(const JsonLike& json, const std::string& enclosingPath, LazyDocument& document,
+      std::vector<LazyGroupJson>& groupJsons)
+    {
+      const std::string path = enclosingPath + '[' + getName() + ']';
+      std::optional<JsonProxy> thisJson = json.find(getName());
+
+      if (!thisJson)
+        throw std::runtime_error("Expected `json" + path + "` to contain a value");
+
+      JsonProxy& configurationJson = document.enclosingJson.emplace_back(std::move(*thisJson));
+
+      for (auto& group : _groups)
+      {
+        std::optional<JsonProxy> groupJson = configurationJson->find(group->getName());
+
+        if (!groupJson)
+          throw std::runtime_error("Expected `json" + path + '[' + group->getName() + "]` to contain a value");
+
+        if (auto* configuration = dynamic_cast<Configuration*>(group.get()))
+        {
+          JsonProxy& wrapperJson = document.enclosingJson.emplace_back(std::move(*groupJson));
+          configuration->collectLazyGroups(wrapperJson, path, document, groupJsons);
+        }
+        else
+        {
+          groupJsons.push_back({ this, group.get(), std::move(*groupJson) });
+        }
+      }
+    }
+
+    // Supersedes the groups deferred by a previous `loadLazy`, also in nested configurations
+    void retainLazyDocument(const std::shared_ptr<const LazyDocument>& document)
+    {
+      _lazyGroups.clear();
+      _lazyDocument = document;
+
+      for (auto& group : _groups)
+      {
+        if (auto* configuration = dynamic_cast<Configuration*>(group.get()))
+          configuration->retainLazyDocument(document);
+      }
+    }
+
+    void loadIfPending(Group& group) const
+    {
+      if (_lazyGroups.empty())
+        return;
+
+      auto iter = _lazyGroups.find(&group);
+
+      if (iter == _lazyGroups.end() || iter->second.isLoaded.load(std::memory_order_acquire))
+        return;
+
+      LazyGroup& lazyGroup = iter->second;
+      std::lock_guard<std::mutex> lock(lazyGroup.mutex);
+
+      if (lazyGroup.isLoaded.load(std::memory_order_relaxed))
+        return;
+
+      try
+      {
+        loadGroup(group, *lazyGroup.json);
+      }
+      catch (const std::exception& exception)
+      {
+        throw std::runtime_error("Cannot load group \"" + group.getName() + "\" of configuration \"" + getName()
+          + "\" on first access: " + exception.what());
+      }
+
+      lazyGroup.json.reset();
+      lazyGroup.isLoaded.store(true, std::memory_order_release);
+    }
+
+    friend class ChangeDispatcher;
+    friend class CompiledBinding;
+    friend class ConfigurationTree;
+    friend class OpaqueGroupLoader;
+
+    GroupSet _groups;
+    ChangeDispatcher* _dispatcher = nullptr;
+
+    std::shared_ptr<const LazyDocument> _lazyDocument;
+    mutable std::unordered_map<const Group*, LazyGroup> _lazyGroups;
+  };
+
+  inline void OpaqueGroupLoader::load()
+  {
+    _failedIndex = 0;
+    _loadedCount = 0;
+
+    for (; _failedIndex < _entries.size(); ++_failedIndex)
+    {
+      Entry& entry = _entries[_failedIndex];
+      entry.backup.clear();
+      Configuration::storeGroup(*entry.group, entry.backup);
+    }
+
+    for (_failedIndex = 0; _failedIndex < _entries.size(); ++_failedIndex)
+    {
+      try
+      {
+        Configuration::loadGroup(*_entries[_failedIndex].group, *_entries[_failedIndex].json);
+        ++_loadedCount;
+      }
+      catch (...)
+      {
+        restore();
+        throw;
+      }
+    }
+  }
+
+  inline void OpaqueGroupLoader::restore() noexcept
+  {
+    for (std::size_t i = 0; i < _loadedCount; ++i)
+    {
+      try
+      {
+        *_entries[i].group << _entries[i].backup;
+      }
+      catch (...)
+      {
+        // The group cannot read back what it wrote; nothing sensible left to do
+      }
+    }
+  }
+
+  inline bool OpaqueGroupLoader::isUnchanged(std::size_t index) const
+  {
+    JsonTree json;
+    Configuration::storeGroup(*_entries[index].group, json);
+
+    return json == _entries[index].backup;
+  }
+
+  inline ChangeDispatcher::ChangeDispatcher(Configuration& configuration)
+  {
+    if (configuration._dispatcher)
+    {
+      throw std::runtime_error("Cannot attach a dispatcher to configuration \"" + configuration.getName()
+        + "\" because another one is attached");
+    }
+
+    configuration._dispatcher = this;
+    _registry->configuration = &configuration;
+  }
+
+  inline ChangeDispatcher::~ChangeDispatcher()
+  {
+    std::lock_guard<std::mutex> lock(_registry->mutex);
+
+    if (_registry->configuration)
+    {
+      _registry->configuration->_dispatcher = nullptr;
+      _registry->unwatchAll();
+    }
+  }
+
+  inline void ChangeDispatcher::watch(std::uint64_t id, std::string_view path)
+  {
+    std::vector<Property*>& watched = _registry->watched[id];
+    std::string groupPath;
+
+    auto visitConfiguration = [&](const Configuration& configuration, auto& self) -> void
+      {
+        std::size_t size = groupPath.size();
+
+        for (const std::shared_ptr<Group>& group : configuration._groups)
+        {
+          groupPath.resize(size);
+          groupPath += group->getName();
+
+          if (auto* nested = dynamic_cast<const Configuration*>(group.get()))
+          {
+            groupPath += '/';
+            self(*nested, self);
+            continue;
+          }
+
+          // The path of a property is below `path` if that of its group is at or below it
+          bool isGroupWatched = groupPath.size() >= path.size() && groupPath.compare(0, path.size(), path) == 0
+            && (groupPath.size() == path.size() || groupPath[path.size()] == '/');
+
+          auto visitor = [&](Property& property)
+            {
+              std::string propertyPath = groupPath + '/' + property.getName();
+
+              if (!isGroupWatched && propertyPath != path)
+                return;
+
+              watched.push_back(&property);
+              auto [iter, isNew] = _registry->watches.try_emplace(&property);
+              Watch& watch = iter->second;
+
+              if (isNew)
+              {
+                watch.registry = _registry.get();
+                watch.group = group;
+                watch.path = std::move(propertyPath);
+                property.setObserver(&watch);
+              }
+
+              ++watch.count;
+            };
+
+          group->forEachProperty(visitor);
+        }
+      };
+
+    try
+    {
+      groupPath = _registry->configuration->getName() + '/';
+      visitConfiguration(*_registry->configuration, visitConfiguration);
+    }
+    catch (...)
+    {
+      _registry->unwatch(id);
+      throw;
+    }
+  }
+
+  // Stages writes to the properties of a configuration, and applies them all or none by `commit`. Values are
+  // validated once, at commit time, together with the constraints spanning several properties of each group
+  // (see `Group::collectInvariantErrors`). Groups are staged through the properties they expose, as by
+  // `Configuration::update`; a group that exposes no properties cannot be staged. The configuration, and the
+  // groups and properties staged, must outlive the transaction; it is not safe to use concurrently.
+  class Transaction
+  {
+  public:
+    explicit Transaction(Configuration& configuration)
+      : _configuration(&configuration)
+    {}
+
+    bool empty() const noexcept
+    {
+      return _groups.empty();
+    }
+
+    // Number of property values staged
+    std::size_t size() const noexcept
+    {
+      return _values.size();
+    }
+
+    // Stages `value` for the property named `propertyName` of the group named `groupName`, replacing a value
+    // staged for it before; throws if there is no such property, or if `T` is not its value type (a string
+    // literal stands for a `StringType`)
+    template<class T>
+    Transaction& set(std::string_view groupName, std::string_view propertyName, T value)
+    {
+      std::shared_ptr<Group> group = _configuration->get(groupName);
+      Property* property = group->findProperty(propertyName);
+
+      if (!property)
+      {
+        throw std::runtime_error("Cannot stage a value for property \"" + std::string(propertyName) + "\" of group \""
+          + group->getName() + "\" because it does not exist");
+      }
+
+      ValueModel model = valueModelFromValueId(property->getValueId());
+
+      if constexpr (std::is_same_v<T, const char*>)
+        model.setValue(StringType(value));
+      else
+        model.setValue(std::move(value));
+
+      auto [groupIndex, isNew] = stageGroup(*group, stageGroup(*_configuration, noGroup).first);
+      stageValue(groupIndex, *property, std::move(model), !isNew);
+
+      return *this;
+    }
+
+    // Stages the values of the properties of the group named `groupName`, read from `groupJson` as by
+    // `group << groupJson`; problems are reported by `commit`, including `ValidationErrc::unsupportedGroup` for a group
+    // that exposes no properties
+    Transaction& load(std::string_view groupName, const JsonLike& groupJson)
+    {
+      std::shared_ptr<Group> group = _configuration->get(groupName);
+      std::size_t parent = stageGroup(*_configuration, noGroup).first;
+
+      if (auto* configuration = dynamic_cast<Configuration*>(group.get()))
+        stageConfiguration(*configuration, groupJson, parent);
+      else
+        stageGroupJson(*group, groupJson, parent);
+
+      return *this;
+    }
+
+    // Stages all values of the configuration, read from `json` as by `configuration << json`
+    Transaction& load(const JsonLike& json)
+    {
+      stageConfiguration(*_configuration, json, noGroup);
+
+      return *this;
+    }
+
+    // Validates all staged values and applies them, then checks the invariants of the groups staged; on failure,
+    // restores all values and throws the messages of all errors found. The transaction is empty afterwards. Once
+    // applied, the values that changed are dispatched to the dispatcher attached to the configuration, if any.
+    void commit()
+    {
+      std::vector<StagedGroup> groups = std::move(_groups);
+      std::vector<StagedValue> values = std::move(_values);
+      std::vector<StagedError> errors = std::move(_errors);
+      clear();
+
+      bool isValid = errors.empty();
+
+      for (std::size_t i = 0; isValid && i < values.size(); ++i)
+        isValid = values[i].property->accepts(values[i].value);
+
+      // Reports are only built on failure
+      if (!isValid)
+      {
+        ValidationReport report;
+        std::vector<const Group*> scopes;
+
+        for (const StagedError& error : errors)
+        {
+          auto collector = [&]() { report.add(error.code, error.property); };
+          enterScopes(report, collectScopes(groups, error.group, scopes), 0, collector);
+        }
+
+        for (const StagedValue& value : values)
+        {
+          if (!value.property->accepts(value.value))
+          {
+            auto collector = [&]() { report.add(ValidationErrc::invalidValue, value.property); };
+            enterScopes(report, collectScopes(groups, value.group, scopes), 0, collector);
+          }
+        }
+
+        throwErrors(report);
+      }
+
+      // The backup is complete before the first value is applied, so that applying cannot fail halfway
+      std::vector<std::pair<ValueModel, bool>> backup;
+      backup.reserve(values.size());
+
+      for (const StagedValue& value : values)
+        backup.emplace_back(value.property->getValueModel(), value.property->isValid());
+
+      for (StagedValue& value : values)
+        value.property->setValueModelUnchecked(std::move(value.value));
+
+      auto restore = [&]() noexcept
+        {
+          for (std::size_t i = 0; i < values.size(); ++i)
+            values[i].property->setValueModelUnchecked(std::move(backup[i].first), backup[i].second);
+        };
+
+      ValidationReport report;
+
+      try
+      {
+        std::vector<const Group*> scopes;
+
+        for (std::size_t i = 0; i < groups.size(); ++i)
+        {
+          auto collector = [&]() { groups[i].group->collectInvariantErrors(report); };
+          enterScopes(report, collectScopes(groups, i, scopes), 0, collector);
+        }
+      }
+      catch (...)
+      {
+        restore();
+        throw;
+      }
+
+      if (!report.isValid())
+      {
+        restore();
+        throwErrors(report);
+      }
+
+      if (ChangeDispatcher* dispatcher = _configuration->getDispatcher())
+        dispatcher->dispatch(collectChanges(groups, values, backup));
+    }
+
+    // Discards all staged values
+    void clear() noexcept
+    {
+      _groups.clear();
+      _values.clear();
+      _errors.clear();
+      _groupIndices.clear();
+    }
+
+  private:
+    static constexpr std::size_t noGroup = std::numeric_limits<std::size_t>::max();
+
+    // Groups are staged with the configurations enclosing them, for reporting paths
+    struct StagedGroup
+    {
+      Group* group;
+
+      // Index of the enclosing configuration in `_groups`, or `noGroup`
+      std::size_t parent;
+    };
+
+    struct StagedValue
+    {
+      std::size_t group;
+      Property* property;
+      ValueModel value;
+    };
+
+    struct StagedError
+    {
+      std::size_t group;
+      ValidationErrc code;
+
+      // A nullptr if the error concerns the group
+      const Property* property;
+    };
+
+    void stageConfiguration(Configuration& configuration, const JsonLike& json, std::size_t parent)
+    {
+      std::size_t index = stageGroup(configuration, parent).first;
+      std::optional<JsonProxy> thisJson = json.find(configuration.getName());
+
+      if (!thisJson)
+      {
+        _errors.push_back({ index, ValidationErrc::missingValue, nullptr });
+        return;
+      }
+
+      configuration.forEachGroup([&](Group& group)
+        {
+          std::optional<JsonProxy> groupJson = (*thisJson)->find(group.getName());
+
+          if (!groupJson)
+            _errors.push_back({ stageGroup(group, index).first, ValidationErrc::missingValue, nullptr });
+          else if (auto* nested = dynamic_cast<Configuration*>(&group))
+            stageConfiguration(*nested, *groupJson, index);
+          else
+            stageGroupJson(group, *groupJson, index);
+        }
+      );
+    }
+
+    void stageGroupJson(Group& group, const JsonLike& json, std::size_t parent)
+    {
+      auto [index, isNew] = stageGroup(group, parent);
+      bool exposesProperties = false;
+
+      auto visitor = [&, index = index, isNew = isNew](Property& property)
+        {
+          exposesProperties = true;
+
+          std::optional<JsonProxy> propertyJson = json.find(property.getName());
+
+          if (!propertyJson)
+            _errors.push_back({ index, ValidationErrc::missingValue, &property });
+          else if (std::optional<ValueModel> value = (*propertyJson)->toValueModel(property.getValueId()); !value)
+            _errors.push_back({ index, ValidationErrc::typeMismatch, &property });
+          else
+            stageValue(index, property, std::move(*value), !isNew);
+        };
+
+      group.forEachProperty(visitor);
+
+      if (!exposesProperties)
+        _errors.push_back({ index, ValidationErrc::unsupportedGroup, nullptr });
+    }
+
+    // Returns the index of `group` in `_groups`, and whether it was staged just now
+    std::pair<std::size_t, bool> stageGroup(Group& group, std::size_t parent)
+    {
+      auto [iter, isNew] = _groupIndices.try_emplace(&group, _groups.size());
+
+      if (isNew)
+        _groups.push_back({ &group, parent });
+
+      return { iter->second, isNew };
+    }
+
+    // A value staged before for `property` can only exist if its group was staged before
+    void stageValue(std::size_t group, Property& property, ValueModel value, bool mayExist)
+    {
+      if (mayExist)
+      {
+        auto iter = std::find_if(_values.begin(), _values.end(),
+          [&property](const StagedValue& staged) { return staged.property == &property; });
+
+        if (iter != _values.end())
+        {
+          iter->value = std::move(value);
+          return;
+        }
+      }
+
+      _values.push_back({ group, &property, std::move(value) });
+    }
+
+    // Fills `scopes` with the staged group at `index` and its enclosing configurations, outermost first
+    static const std::vector<const Group*>& collectScopes(const std::vector<StagedGroup>& groups, std::size_t index,
+      std::vector<const Group*>& scopes)
+    {
+      scopes.clear();
+
+      for (; index != noGroup; index = groups[index].parent)
+        scopes.push_back(groups[index].group);
+
+      std::reverse(scopes.begin(), scopes.end());
+
+      return scopes;
+    }
+
+    // The applied values that differ from their backup, with their paths as in `ValidationReport::getPath`
+    static ChangeSet collectChanges(const std::vector<StagedGroup>& groups, const std::vector<StagedValue>& values,
+      const std::vector<std::pair<ValueModel, bool>>& backup)
+    {
+      ChangeSet changes;
+      std::vector<const Group*> scopes;
+
+      for (std::size_t i = 0; i < values.size(); ++i)
+      {
+        Property& property = *values[i].property;
+
+        if (backup[i].second && backup[i].first == property.getValueModel())
+          continue;
+
+        std::string path;
+
+        for (const Group* scope : collectScopes(groups, values[i].group, scopes))
+          path += scope->getName() + '/';
+
+        changes.add(path + property.getName(), *groups[values[i].group].group, &property);
+      }
+
+      return changes;
+    }
+
+    // Calls `function` within the scopes `scopes[index...]`, for the paths of the errors it reports
+    template<class TFunction>
+    static void enterScopes(ValidationReport& report, const std::vector<const Group*>& scopes, std::size_t index,
+      TFunction& function)
+    {
+      if (index == scopes.size())
+      {
+        function();
+        return;
+      }
+
+      auto scope = report.enter(*scopes[index]);
+      enterScopes(report, scopes, index + 1, function);
+    }
+
+    void throwErrors(const ValidationReport& report) const
+    {
+      if (report.isValid())
+        return;
+
+      std::string message;
+
+      for (const ValidationError& error : report.getErrors())
+        message += "\n  " + report.getMessage(error);
+
+      throw std::runtime_error("Cannot commit transaction on configuration \"" + _configuration->getName() + '"'
+        + message);
+    }
+
+    Configuration* _configuration;
+    std::vector<StagedGroup> _groups;
+    std::vector<StagedValue> _values;
+    std::vector<StagedError> _errors;
+    std::unordered_map<const Group*, std::size_t> _groupIndices;
+  };
+
+  // The json structure of a configuration, resolved once: a tree of nodes whose children are ordered by key, down
+  // to the values read from json, its leaves: the properties exposed by groups, and the groups that expose none.
+  // Of properties exposed twice by the same name, the first one is a leaf, as found by `Group::findProperty`. A tree
+  // refers to the groups and properties present when it was built.
+  class ConfigurationTree
+  {
+  public:
+    enum class NodeKind
+    {
+      wrapper,       // An object holding `group` (a configuration) by its name
+      configuration, // An object holding the groups of `group` (a configuration) by their names
+      group,         // An object holding the properties exposed by `group` by their names
+      opaqueGroup,   // The json read by `group` through its `operator<<`; a leaf
+      property       // The value of `property`; a leaf
+    };
+
+    struct Node
+    {
+      std::string key;
+
+      // E.g. "[myConfig][logging][level]", as in the messages of `Configuration::operator<<`
+      std::string jsonPath;
+
+      // E.g. "myConfig/logging/level", as in `ValidationReport::getPath`
+      std::string path;
+
+      NodeKind kind;
+      Group* group;
+      Property* property;
+      std::size_t parent;
+
+      // Children are adjacent, and ordered by key
+      std::size_t firstChild = 0;
+      std::size_t childCount = 0;
+
+      // Into `getLeaves()`, for a leaf
+      std::size_t leaf = 0;
+
+      bool isLeaf() const noexcept
+      {
+        return kind == NodeKind::property || kind == NodeKind::opaqueGroup;
+      }
+    };
+
+    // The root, at index 0, is the object holding `configuration` by its name
+    explicit ConfigurationTree(Configuration& configuration)
+    {
+      _nodes.push_back({ {}, {}, {}, NodeKind::wrapper, &configuration, nullptr, 0 });
+      expand(0);
+    }
+
+    const Node& operator[](std::size_t index) const noexcept
+    {
+      return _nodes[index];
+    }
+
+    // Number of nodes; they are numbered depth first
+    std::size_t size() const noexcept
+    {
+      return _nodes.size();
+    }
+
+    // The indices of the leaves, depth first
+    const std::vector<std::size_t>& getLeaves() const noexcept
+    {
+      return _leaves;
+    }
+
+    // The index of the child named `key` of the node at `index`; 0 (the root, which is no child) if there is none
+    std::size_t findChild(std::size_t index, std::string_view key) const noexcept
+    {
+      auto first = _nodes.cbegin() + static_cast<std::ptrdiff_t>(_nodes[index].firstChild);
+      auto last = first + static_cast<std::ptrdiff_t>(_nodes[index].childCount);
+      auto iter = std::lower_bound(first, last, key, [](const Node& node, std::string_view key) { return node.key < key; });
+
+      return iter != last && iter->key == key ? static_cast<std::size_t>(iter - _nodes.cbegin()) : 0;
+    }
+
+    // Looks up the json of the node at `index` in `json`, the json of the root
+    std::optional<JsonProxy> findJson(const JsonLike& json, std::size_t index) const
+    {
+      std::vector<std::size_t> nodes;
+
+      for (; index != 0; index = _nodes[index].parent)
+        nodes.push_back(index);
+
+      if (nodes.empty())
+        throw std::runtime_error("Cannot find the json of the root of a configuration tree");
+
+      std::optional<JsonProxy> current = json.find(_nodes[nodes.back()].key);
+
+      for (auto iter = std::next(nodes.crbegin()); current && iter != nodes.crend(); ++iter)
+        current = (*current)->find(_nodes[*iter].key);
+
+      return current;
+    }
+
+  private:
+    void expand(std::size_t index)
+    {
+      std::vector<Node> children;
+      NodeKind kind = _nodes[index].kind;
+      Group* group = _nodes[index].group;
+      const std::string jsonPath = _nodes[index].jsonPath;
+      const std::string path = _nodes[index].path;
+
+      auto addChild = [&](const std::string& key, NodeKind childKind, Group* childGroup, Property* property)
+        {
+          // A nested configuration appears twice in json, but once in paths
+          std::string childPath = path;
+
+          if (kind != NodeKind::wrapper || index == 0)
+            childPath += (childPath.empty() ? "" : "/") + key;
+
+          children.push_back({ key, jsonPath + '[' + key + ']', std::move(childPath), childKind, childGroup, property, index });
+        };
+
+      if (kind == NodeKind::wrapper)
+      {
+        addChild(group->getName(), NodeKind::configuration, group, nullptr);
+      }
+      else if (kind == NodeKind::configuration)
+      {
+        // Without loading groups deferred by `Configuration::loadLazy`
+        for (auto& child : static_cast<Configuration*>(group)->_groups)
+        {
+          if (dynamic_cast<Configuration*>(child.get()))
+          {
+            addChild(child->getName(), NodeKind::wrapper, child.get(), nullptr);
+            continue;
+          }
+
+          bool exposesProperties = false;
+          child->forEachProperty([&exposesProperties](Property&) { exposesProperties = true; });
+
+          addChild(child->getName(), exposesProperties ? NodeKind::group : NodeKind::opaqueGroup, child.get(), nullptr);
+        }
+      }
+      else
+      {
+        auto visitor = [&](Property& property)
+          {
+            addChild(property.getName(), NodeKind::property, group, &property);
+          };
+
+        group->forEachProperty(visitor);
+      }
+
+      std::stable_sort(children.begin(), children.end(),
+        [](const Node& lhs, const Node& rhs) { return lhs.key < rhs.key; });
+      children.erase(std::unique(children.begin(), children.end(),
+        [](const Node& lhs, const Node& rhs) { return lhs.key == rhs.key; }), children.end());
+
+      std::size_t firstChild = _nodes.size();
+      _nodes[index].firstChild = firstChild;
+      _nodes[index].childCount = children.size();
+
+      for (Node& child : children)
+      {
+        if (child.isLeaf())
+        {
+          child.leaf = _leaves.size();
+          _leaves.push_back(_nodes.size());
+        }
+
+        _nodes.push_back(std::move(child));
+      }
+
+      for (std::size_t i = firstChild; i < firstChild + children.size(); ++i)
+      {
+        if (!_nodes[i].isLeaf())
+          expand(i);
+      }
+    }
+
+    // Depth first, starting with the root
+    std::vector<Node> _nodes;
+
+    std::vector<std::size_t> _leaves;
+  };
+
+  // The json paths of the values of a configuration, resolved once (see `ConfigurationTree`), so that `load` reads a
+  // document in one ordered pass: the members of each json object are matched against the names expected there in
+  // key order (see `JsonLike::forEachMember`), rather than looked up one name at a time; members that no group
+  // consumes are skipped, and those after the last expected one are not enumerated. Json that cannot enumerate its
+  // members is read by `find` instead. Groups are read through the properties they expose, as by
+  // `Configuration::update`; a group that exposes no properties is read by its `operator<<`. A binding refers to the
+  // groups and properties present when it was compiled, and has to be compiled again after groups are inserted or
+  // removed. It is not safe to use concurrently.
+  class CompiledBinding
+  {
+  public:
+    explicit CompiledBinding(Configuration& configuration)
+      : _configuration(&configuration)
+      , _tree(configuration)
+    {
+      bind();
+    }
+
+    // Resolves the paths of the groups and properties currently in the configuration
+    void compile()
+    {
+      _tree = ConfigurationTree(*_configuration);
+      bind();
+    }
+
+    // Number of property values bound
+    std::size_t size() const noexcept
+    {
+      return _properties.size();
+    }
+
+    // Like `operator<<` of the configuration, but all values are read and validated before any is applied, and
+    // nothing is modified if one is missing or invalid; the first error found, in key order, is thrown. Groups that
+    // expose no properties are loaded all or none once all values are read (see `OpaqueGroupLoader`), and the values
+    // are applied only if they succeed. Supersedes groups deferred by `Configuration::loadLazy`, and notifies the
+    // attached dispatcher once applied.
+    void load(const JsonLike& json)
+    {
+      try
+      {
+        read(0, json);
+
+        OpaqueGroupLoader loader;
+
+        for (std::size_t i = 0; i < _opaqueNodes.size(); ++i)
+          loader.add(*_tree[_opaqueNodes[i]].group, *_groupJson[i]);
+
+        try
+        {
+          loader.load();
+        }
+        catch (const std::exception& exception)
+        {
+          throw std::runtime_error("`json" + _tree[_opaqueNodes[loader.getFailedIndex()]].jsonPath + "`: "
+            + exception.what());
+        }
+      }
+      catch (...)
+      {
+        releaseGroupJson();
+        throw;
+      }
+
+      releaseGroupJson();
+
+      for (std::size_t i = 0; i < _properties.size(); ++i)
+        _properties[i]->setValueModelUnchecked(std::move(_values[i]));
+
+      // Superseded
+      for (Configuration* configuration : _configurations)
+      {
+        if (!configuration->_lazyGroups.empty())
+          configuration->discardLazyGroups();
+      }
+
+      _configuration->notifyReloaded();
+    }
+
+  private:
+    using NodeKind = ConfigurationTree::NodeKind;
+    using Node = ConfigurationTree::Node;
+
+    // Allocates the staging slots of the leaves of `_tree`
+    void bind()
+    {
+      _configurations.clear();
+      _slots.clear();
+      _opaqueNodes.clear();
+      _properties.clear();
+      _values.clear();
+      _groupJson.clear();
+
+      for (std::size_t i = 0; i < _tree.size(); ++i)
+      {
+        if (_tree[i].kind == NodeKind::wrapper)
+          _configurations.push_back(static_cast<Configuration*>(_tree[i].group));
+      }
+
+      for (std::size_t index : _tree.getLeaves())
+      {
+        const Node& node = _tree[index];
+
+        if (node.kind == NodeKind::property)
+        {
+          _slots.push_back(_properties.size());
+          _properties.push_back(node.property);
+          _values.emplace_back(node.property->getValueId());
+        }
+        else
+        {
+          _slots.push_back(_opaqueNodes.size());
+          _opaqueNodes.push_back(index);
+          _groupJson.emplace_back();
+        }
+      }
+    }
+
+    // Reads the members of `json` expected by the node at `index`, an object
+    void read(std::size_t index, const JsonLike& json)
+    {
+      std::size_t next = _tree[index].firstChild;
+      std::size_t end = next + _tree[index].childCount;
+
+      auto visitor = [&](const std::string& key, JsonProxy& member)
+        {
+          // Expected members are missing unless ordered after `key`, and members not expected are skipped
+          int order = _tree[next].key.compare(key);
+
+          if (order < 0)
+            throwMissing(_tree[next]);
+
+          if (order == 0)
+            readMember(next++, member);
+
+          return next < end;
+        };
+
+      if (next < end && json.forEachMember(std::ref(visitor)))
+      {
+        if (next < end)
+          throwMissing(_tree[next]);
+
+        return;
+      }
+
+      for (; next < end; ++next)
+      {
+        std::optional<JsonProxy> member = json.find(_tree[next].key);
+
+        if (!member)
+          throwMissing(_tree[next]);
+
+        readMember(next, *member);
+      }
+    }
+
+    void readMember(std::size_t index, JsonProxy& json)
+    {
+      const Node& node = _tree[index];
+
+      if (json->isEmpty())
+        throwMissing(node);
+
+      if (node.kind == NodeKind::opaqueGroup)
+      {
+        _groupJson[_slots[node.leaf]] = std::move(json);
+      }
+      else if (node.kind == NodeKind::property)
+      {
+        const Property& property = *node.property;
+        ValueModel& value = _values[_slots[node.leaf]];
+
+        if (!json->holds(value.getValueId()))
+        {
+          throw std::runtime_error("Expected `json" + node.jsonPath + "` to contain a value of type `"
+            + valueNameFromValueId(value.getValueId()) + '`');
+        }
+
+        // In place, so that the staged values keep their type, and strings their capacity, across loads
+        switch (value.getValueId())
+        {
+        case ValueId::integer:
+          value.setValueUnchecked(json->operator IntegerType());
+          break;
+        case ValueId::real:
+          value.setValueUnchecked(json->operator RealType());
+          break;
+        default:
+          if (std::optional<std::string_view> view = json->viewString())
+            value.assignStringUnchecked(*view);
+          else
+            value.setValueUnchecked(json->operator StringType());
+        }
+
+        if (!property.accepts(value))
+          throw std::runtime_error("Value of `json" + node.jsonPath + "` is invalid");
+      }
+      else
+      {
+        read(index, json);
+      }
+    }
+
+    [[noreturn]] static void throwMissing(const Node& node)
+    {
+      throw std::runtime_error("Expected `json" + node.jsonPath + "` to contain a value");
+    }
+
+    // The json of opaque groups refers to the document loaded
+    void releaseGroupJson() noexcept
+    {
+      for (std::optional<JsonProxy>& json : _groupJson)
+        json.reset();
+    }
+
+    Configuration* _configuration;
+    ConfigurationTree _tree;
+
+    // Those of `_configuration` and its nested configurations
+    std::vector<Configuration*> _configurations;
+
+    // Per leaf of `_tree`, into `_values` and `_properties` for a property, into `_groupJson` and `_opaqueNodes` for
+    // an opaque group
+    std::vector<std::size_t> _slots;
+
+    std::vector<std::size_t> _opaqueNodes;
+    std::vector<Property*> _properties;
+
+    // Read by `load`, before being applied
+    std::vector<ValueModel> _values;
+    std::vector<std::optional<JsonProxy>> _groupJson;
+  };
+
+  inline namespace schemas
+  {
+    // Compile-time description of a numeric property
+    template<class T>
+    struct NumericField
+    {
+      static_assert(valueIdFromValueType<T> == ValueId::integer || valueIdFromValueType<T> == ValueId::real);
+
+      using ValueType = T;
+      using StorageType = T;
+      static constexpr ValueId valueId = valueIdFromValueType<T>;
+
+      std::string_view name;
+      T lowerBound;
+      T upperBound;
+      T defaultValue;
+
+      constexpr bool isValid(T value) const noexcept
+      {
+        return value >= lowerBound && value <= upperBound;
+      }
+
+      constexpr bool isDefaultValid() const noexcept
+      {
+        return lowerBound <= upperBound && isValid(defaultValue);
+      }
+
+      constexpr StorageType defaultStorage() const noexcept
+      {
+        return defaultValue;
+      }
+
+      // Leaves `storage` unchanged and returns false if `value` is invalid
+      constexpr bool toStorage(T value, StorageType& storage) const noexcept
+      {
+        bool valid = isValid(value);
+
+        if (valid)
+          storage = value;
+
+        return valid;
+      }
+
+      constexpr T fromStorage(StorageType storage) const noexcept
+      {
+        return storage;
+      }
+    };
+
+    // Compile-time description of a choice property; a value is stored as an index into `choices`
+    template<class T, std::size_t N>
+    struct ChoiceField
+    {
+      static_assert(std::is_same_v<T, IntegerType> || std::is_same_v<T, std::string_view>);
+
+      using ValueType = T;
+      using StorageType = std::uint32_t;
+      static constexpr ValueId valueId = std::is_same_v<T, IntegerType> ? ValueId::integer : ValueId::string;
+
+      std::string_view name;
+      std::array<T, N> choices;
+      T defaultValue;
+
+      // Returns `N` if `value` is not one of `choices`
+      constexpr std::size_t indexOf(const T& value) const noexcept
+      {
+        std::size_t index = 0;
+
+        while (index < N && !(choices[index] == value))
+          ++index;
+
+        return index;
+      }
+
+      constexpr bool isValid(const T& value) const noexcept
+      {
+        return indexOf(value) < N;
+      }
+
+      constexpr bool isDefaultValid() const noexcept
+      {
+        return isValid(defaultValue);
+      }
+
+      constexpr StorageType defaultStorage() const noexcept
+      {
+        return static_cast<StorageType>(indexOf(defaultValue));
+      }
+
+      // Leaves `storage` unchanged and returns false if `value` is invalid
+      constexpr bool toStorage(const T& value, StorageType& storage) const noexcept
+      {
+        std::size_t index = indexOf(value);
+
+        if (index < N)
+          storage = static_cast<StorageType>(index);
+
+        return index < N;
+      }
+
+      constexpr const T& fromStorage(StorageType storage) const noexcept
+      {
+        return choices[storage];
+      }
+    };
+
+    template<class T>
+    constexpr NumericField<T> numericField(std::string_view name, T lowerBound, T upperBound, T defaultValue)
+    {
+      return { name, lowerBound, upperBound, defaultValue };
+    }
+
+    template<class T, std::size_t N, std::size_t... I>
+    constexpr ChoiceField<T, N> choiceFieldImpl(std::string_view name, const T(&choices)[N], T defaultValue, std::index_sequence<I...>)
+    {
+      return { name, { choices[I]... }, defaultValue };
+    }
+
+    template<std::size_t N>
+    constexpr ChoiceField<IntegerType, N> choiceField(std::string_view name, const IntegerType(&choices)[N], IntegerType defaultValue)
+    {
+      return choiceFieldImpl(name, choices, defaultValue, std::make_index_sequence<N>{});
+    }
+
+    template<std::size_t N>
+    constexpr ChoiceField<std::string_view, N> choiceField(std::string_view name, const std::string_view(&choices)[N], std::string_view defaultValue)
+    {
+      return choiceFieldImpl(name, choices, defaultValue, std::make_index_sequence<N>{});
+    }
+
+    template<std::size_t I, class T>
+    struct SchemaSlot
+    {
+      T value;
+    };
+
+    template<class Indices, class... Ts>
+    struct SchemaLayout;
+
+    // Distinct for each field; fields are told apart by type, since comparing their addresses is not a constant
+    // expression on every compiler
+    template<const auto& Field>
+    struct SchemaFieldTag
+    {};
+
+    // Aggregate of one slot per field; trivially copyable since every slot is
+    template<std::size_t... I, class... Ts>
+    struct SchemaLayout<std::index_sequence<I...>, Ts...> : SchemaSlot<I, Ts>...
+    {};
+
+    // Group whose properties are declared at compile time by `Fields`, i.e. references to `constexpr` field
+    // descriptions (see `numericField` and `choiceField`). A default value that fails its field's constraint is
+    // rejected at compile time. The values of a group are held by a trivially copyable layout, so that
+    // constructing a group copies a static default layout, and a value can only be replaced by a valid one.
+    // E.g. `SchemaGroup<Schema::level, Schema::period>`, read by `getValue<Schema::level>()`.
+    // Since its values are not `Property` objects, a schema group exposes no properties (see
+    // `Group::forEachProperty`) and is handled as a whole, like any group that exposes none:
+    // - `validate(json)` checks each field; `validate()` only checks invariants, as the values are always valid
+    // - `Configuration::update` and `ConfigurationLayers` reload it as a whole, and report it as a single change
+    // - `PropertyHandle`, `CachedProperty`, `NumericBatch` and `FrozenConfiguration` cannot refer to its values
+    // - `Transaction` reports it as `ValidationErrc::unsupportedGroup`
+    template<const auto&... Fields>
+    class SchemaGroup : public Group
+    {
+      static_assert(sizeof...(Fields) > 0);
+      static_assert((Fields.isDefaultValid() && ...), "The default value of a schema field fails the field's constraint");
+
+      template<std::size_t I>
+      static constexpr const auto& fieldAt() noexcept
+      {
+        return std::get<I>(std::tie(Fields...));
+      }
+
+      template<std::size_t I>
+      using FieldAt = std::decay_t<decltype(fieldAt<I>())>;
+
+      using Layout = SchemaLayout<std::index_sequence_for<decltype(Fields)...>, typename std::decay_t<decltype(Fields)>::StorageType...>;
+      static_assert(std::is_trivially_copyable_v<Layout>);
+
+      static constexpr Layout defaultLayout{ { Fields.defaultStorage() }... };
+
+      template<const auto& Field>
+      static constexpr std::size_t indexOf() noexcept
+      {
+        constexpr bool matches[] = { std::is_same_v<SchemaFieldTag<Field>, SchemaFieldTag<Fields>>... };
+
+        std::size_t index = 0;
+
+        while (index < sizeof...(Fields) && !matches[index])
+          ++index;
+
+        return index;
+      }
+
+    public:
+      SchemaGroup(std::string_view name)
+        : Group(name)
+        , _layout(defaultLayout)
+      {}
+
+      template<const auto& Field>
+      decltype(auto) getValue() const noexcept
+      {
+        constexpr std::size_t index = indexOf<Field>();
+        static_assert(index < sizeof...(Fields), "The field is not part of this schema");
+
+        return Field.fromStorage(slot<index>(_layout));
+      }
+
+      // Throws, leaving the value unchanged, if `value` is invalid
+      template<const auto& Field>
+      void setValue(const typename std::decay_t<decltype(Field)>::ValueType& value)
+      {
+        constexpr std::size_t index = indexOf<Field>();
+        static_assert(index < sizeof...(Fields), "The field is not part of this schema");
+
+        if (!Field.toStorage(value, slot<index>(_layout)))
+          throw std::runtime_error("Value of property named \"" + std::string(Field.name) + "\" is invalid");
+      }
+
+      // Applies all values or none
+      void operator<<(const JsonLike& json) override
+      {
+        Layout layout = _layout;
+        readFields(json, layout, std::index_sequence_for<decltype(Fields)...>{});
+        _layout = layout;
+      }
+
+      void operator>>(JsonLike& json) const override
+      {
+        writeFields(json, std::index_sequence_for<decltype(Fields)...>{});
+      }
+
+      void collectErrors(const JsonLike& json, ValidationReport& report) const override
+      {
+        auto scope = report.enter(*this);
+        collectFieldErrors(json, report, std::index_sequence_for<decltype(Fields)...>{});
+      }
+
+      using Group::collectErrors;
+
+    private:
+      template<std::size_t I>
+      static typename FieldAt<I>::StorageType& slot(Layout& layout) noexcept
+      {
+        return static_cast<SchemaSlot<I, typename FieldAt<I>::StorageType>&>(layout).value;
+      }
+
+      template<std::size_t I>
+      static const typename FieldAt<I>::StorageType& slot(const Layout& layout) noexcept
+      {
+        return static_cast<const SchemaSlot<I, typename FieldAt<I>::StorageType>&>(layout).value;
+      }
+
+      template<std::size_t... I>
+      static void readFields(const JsonLike& json, Layout& layout, std::index_sequence<I...>)
+      {
+        (readField<I>(json, layout), ...);
+      }
+
+      template<std::size_t I>
+      static void readField(const JsonLike& json, Layout& layout)
+      {
+        constexpr const auto& field = fieldAt<I>();
+        JsonProxy fieldJson = json.at(std::string(field.name));
+
+        bool valid;
+
+        if constexpr (FieldAt<I>::valueId == ValueId::string)
+          valid = field.toStorage(std::string_view(fieldJson.getValue<StringType>()), slot<I>(layout));
+        else
+          valid = field.toStorage(fieldJson.getValue<typename FieldAt<I>::ValueType>(), slot<I>(layout));
 
-      void setValidChoices(const std::vector<std::string>& choices)
-      {
-        setValidChoicesImpl(choices);
+        if (!valid)
+          throw std::runtime_error("Value of property named \"" + std::string(field.name) + "\" is invalid");
       }
 
-      virtual ValueId getValueId() const noexcept override
+      template<std::size_t... I>
+      void writeFields(JsonLike& json, std::index_sequence<I...>) const
       {
-        return _validChoices.front()->getValueId();
+        (writeField<I>(json), ...);
       }
 
-      virtual ConstraintId getConstraintId() const noexcept override
+      template<std::size_t I>
+      void writeField(JsonLike& json) const
       {
-        return ConstraintId::choice;
+        constexpr const auto& field = fieldAt<I>();
+        JsonProxy fieldJson = json[std::string(field.name)];
+
+        if constexpr (FieldAt<I>::valueId == ValueId::string)
+          fieldJson = StringType(field.fromStorage(slot<I>(_layout)));
+        else
+          fieldJson = field.fromStorage(slot<I>(_layout));
       }
 
-      virtual bool isValid(const ValueModel& valueModel) const noexcept override
+      template<std::size_t... I>
+      static void collectFieldErrors(const JsonLike& json, ValidationReport& report, std::index_sequence<I...>)
       {
-        auto pos = std::find_if(_validChoices.cbegin(), _validChoices.cend(), [&valueModel](auto& validChoicePtr)
-          { return valueModel == *validChoicePtr; }
-        );
-
-        return pos != _validChoices.cend();
+        (collectFieldError<I>(json, report), ...);
       }
 
-    private:
-      template<class T>
-      void setValidChoicesImpl(const std::vector<T>& choices)
+      template<std::size_t I>
+      static void collectFieldError(const JsonLike& json, ValidationReport& report)
       {
-        constexpr ValueId effectiveValueId = valueIdFromValueType<T>;
-        static_assert(effectiveValueId != ValueId::unknown);
-
-        using EffectiveValueModel = ValueModelTypeFromValueId<effectiveValueId>;
-        static_assert(!std::is_same_v<EffectiveValueModel, valuemodels::UnknownValueModel>);
+        constexpr const auto& field = fieldAt<I>();
+        constexpr ValueId valueId = FieldAt<I>::valueId;
 
-        if (choices.empty())
-          throw std::runtime_error("Parameter `choices` cannot be an empty vector");
+        std::optional<JsonProxy> fieldJson = json.find(std::string(field.name));
+        std::optional<ValueModel> value;
 
-        _validChoices.clear();
-        _validChoices.reserve(choices.size());
+        if (fieldJson)
+          value = (*fieldJson)->toValueModel(valueId);
 
-        for (const auto& choice : choices)
-          _validChoices.push_back(std::make_unique<EffectiveValueModel>(choice));
+        if (!fieldJson)
+          report.add(ValidationErrc::missingValue, field.name, valueId);
+        else if (!value)
+          report.add(ValidationErrc::typeMismatch, field.name, valueId);
+        else if (!field.isValid(typename FieldAt<I>::ValueType(std::as_const(*value).getValueUnchecked<ValueTypeFromValueId<valueId>>())))
+          report.add(ValidationErrc::invalidValue, field.name, valueId);
       }
 
-    protected:
-      std::vector<std::unique_ptr<ValueModel>> _validChoices;
+      Layout _layout;
     };
   }
 
-  class Property
+  template<class TConfiguration>
+  class AtomicConfiguration;
+
+  // Typed reference to a validated property of a configuration, read without checks. A handle that follows an
+  // `AtomicConfiguration` resolves itself again on a read after a newer snapshot is published, so it belongs to one
+  // thread at a time.
+  template<class T>
+  class PropertyHandle
   {
+    static constexpr ValueId valueId = valueIdFromValueType<T>;
+    static_assert(valueId != ValueId::unknown);
+
   public:
-    Property(std::string name, std::unique_ptr<Constraint> constraint)
-      : _name(std::move(name))
-      , _constraint(std::move(constraint))
-      , _valueModel(valueModelFromValueId(_constraint->getValueId()))
+    PropertyHandle() = default;
+
+    PropertyHandle(std::shared_ptr<const Configuration> configuration, std::string groupName, std::string propertyName)
+      : _groupName(std::move(groupName))
+      , _propertyName(std::move(propertyName))
     {
+      rebind(std::move(configuration));
     }
 
-    virtual ~Property() = default;
-
-    Property(Property&&) = default;
-    Property& operator=(Property&&) = default;
+    // Does not share ownership; `configuration` must outlive this handle
+    PropertyHandle(const Configuration& configuration, std::string groupName, std::string propertyName)
+      : PropertyHandle(std::shared_ptr<const Configuration>(std::shared_ptr<void>(), &configuration),
+          std::move(groupName), std::move(propertyName))
+    {}
 
-    const std::string& getName() const noexcept
+    // Follows the snapshots published by `source`, which must outlive this handle. Throws if nothing has been
+    // published yet.
+    template<class TConfiguration>
+    PropertyHandle(const AtomicConfiguration<TConfiguration>& source, std::string groupName, std::string propertyName)
+      : _groupName(std::move(groupName))
+      , _propertyName(std::move(propertyName))
+      , _source(&source)
+      , _sourceGeneration([](const void* source) { return static_cast<const AtomicConfiguration<TConfiguration>*>(source)->getGeneration(); })
+      , _sourceLoad([](const void* source) -> std::shared_ptr<const Configuration> { return static_cast<const AtomicConfiguration<TConfiguration>*>(source)->load(); })
     {
-      return _name;
+      follow();
     }
 
-    template<class T>
-    const T& getValue() const
+    // Resolves this handle against `configuration` by the group and property names it was created with. A handle
+    // that followed an `AtomicConfiguration` stops following it.
+    void rebind(std::shared_ptr<const Configuration> configuration)
     {
-      assertValuePassesConstraint();
-      return _valueModel->getValue<T>();
+      _property = resolve(std::move(configuration));
+      _source = nullptr;
     }
 
-    template<class T>
-    void setValue(const T& value)
+    bool isBound() const noexcept
     {
-      _valueModel->setValue(value);
-      assertValuePassesConstraint();
+      return static_cast<bool>(_property);
     }
 
-    void setConstraint(std::unique_ptr<Constraint> constraint)
+    // Requires `isBound()`
+    const T& get() const
     {
-      if (_constraint->getConstraintId() != constraint->getConstraintId())
-      {
-        throw std::runtime_error("Cannot set a new constraint for property named \"" + _name
-          + "\"; attempted to replace a constraint of type `" + constraintNameFromId(_constraint->getConstraintId())
-          + "` with an unrelated constraint of type `" + constraintNameFromId(constraint->getConstraintId()) + '`');
-      }
+      if (_source && _sourceGeneration(_source) != _generation)
+        follow();
 
-      if (_constraint->getValueId() != constraint->getValueId())
-      {
-#if 1
-        _valueModel = valueModelFromValueId(constraint->getValueId());
-#else
-        throw std::runtime_error("Cannot set a new constraint for property named \"" + _name
-          + "\"; attempted to replace a constraint with a value type `" + valueNameFromValueId(_constraint->getValueId())
-          + "` with a constraint with a value type `" + valueNameFromValueId(constraint->getValueId()) + '`');
-#endif
-      }
+      assert(_property && "Reading an unbound PropertyHandle");
+      return _property->getValueUnchecked<T>();
+    }
 
-      _constraint = std::move(constraint);
+    const T& operator*() const
+    {
+      return get();
     }
 
-    const Constraint& getConstraint() const noexcept
+    const Property& getProperty() const
     {
-      return *_constraint;
+      get();
+      return *_property;
     }
 
   private:
-    void assertValuePassesConstraint() const
+    std::shared_ptr<const Property> resolve(std::shared_ptr<const Configuration> configuration) const
     {
-      if (!_constraint->isValid(*_valueModel))
-        throw std::runtime_error("Value of property named \"" + _name + "\" is invalid");
-    }
+      if (!configuration)
+        throw std::runtime_error("Parameter `configuration` is a nullptr");
 
-    std::string _name;
-    std::unique_ptr<Constraint> _constraint;
-    std::unique_ptr<ValueModel> _valueModel;
-  };
+      const Property* property = configuration->get(_groupName)->findProperty(_propertyName);
 
-  inline namespace properties
-  {
-    class NumericProperty : public Property
+      if (!property)
+        throw std::runtime_error("Cannot resolve a handle to property named \"" + _propertyName
+          + "\" because group \"" + _groupName + "\" does not expose it");
+
+      if (property->getValueId() != valueId)
+        throw std::runtime_error("Cannot resolve a handle of value type `" + valueNameFromValueId(valueId)
+          + "` to property named \"" + _propertyName + "\" with a value type `" + valueNameFromValueId(property->getValueId()) + '`');
+
+      if (!property->isValid())
+        throw std::runtime_error("Cannot resolve a handle to property named \"" + _propertyName + "\" because its value is invalid");
+
+      return std::shared_ptr<const Property>(std::move(configuration), property);
+    }
+
+    // A snapshot newer than `_generation` may be loaded, in which case the next read resolves again
+    void follow() const
     {
-    public:
-      using ConstraintType = NumericConstraint;
+      std::uint64_t generation = _sourceGeneration(_source);
+      std::shared_ptr<const Configuration> configuration = _sourceLoad(_source);
 
-      NumericProperty(std::string name, std::pair<int, int> limits)
-        : Property(std::move(name), std::make_unique<ConstraintType>(limits.first, limits.second))
-      {}
+      if (!configuration)
+        throw std::runtime_error("Cannot resolve a handle to property named \"" + _propertyName + "\" because no configuration has been published");
 
-      NumericProperty(std::string name, std::pair<double, double> limits)
-        : Property(std::move(name), std::make_unique<ConstraintType>(limits.first, limits.second))
-      {}
+      _property = resolve(std::move(configuration));
+      _generation = generation;
+    }
 
-      // Throws unless the matching constructor was used
-      void setConstraint(int lowerBound, int upperBound)
-      {
-        Property::setConstraint(std::make_unique<ConstraintType>(lowerBound, upperBound));
-      }
+    std::string _groupName;
+    std::string _propertyName;
 
-      // Throws unless the matching constructor was used
-      void setConstraint(double lowerBound, double upperBound)
-      {
-        Property::setConstraint(std::make_unique<ConstraintType>(lowerBound, upperBound));
-      }
-    };
+    // Shares ownership of the configuration that the property belongs to. Written by `get` of a following handle,
+    // without synchronisation
+    mutable std::shared_ptr<const Property> _property;
 
-    class ChoiceProperty : public Property
-    {
-    public:
-      using ConstraintType = ChoiceConstraint;
+    // The `AtomicConfiguration` followed, if any, and the generation of the snapshot `_property` belongs to
+    const void* _source = nullptr;
+    std::uint64_t (*_sourceGeneration)(const void*) = nullptr;
+    std::shared_ptr<const Configuration> (*_sourceLoad)(const void*) = nullptr;
+    mutable std::uint64_t _generation = 0; // As `_property`
+  };
 
-      ChoiceProperty(std::string name, const std::vector<int>& choices)
-        : Property(std::move(name), std::make_unique<ConstraintType>(choices))
-      {}
+  // Publishes immutable configuration snapshots to concurrent readers. A reload builds and loads a fresh
+  // configuration off the hot path and then swaps it in atomically, so readers never observe a partially
+  // loaded configuration. A snapshot is released once the last reader holding it lets go of it. Snapshots are
+  // swapped through the atomic `std::shared_ptr` accessors, which are lock-based with libstdc++ (a pool of
+  // mutexes guards them); only the generation counter is lock-free.
+  template<class TConfiguration = Configuration>
+  class AtomicConfiguration
+  {
+    static_assert(std::is_base_of_v<Configuration, TConfiguration>);
+
+  public:
+    using Snapshot = std::shared_ptr<const TConfiguration>;
 
-      ChoiceProperty(std::string name, const std::vector<std::string>& choices)
-        : Property(std::move(name), std::make_unique<ConstraintType>(choices))
+    // Caches the current snapshot for a single thread. Instances are not thread-safe; use one per thread.
+    // Reading a cached snapshot is wait-free; only a reader that observes a newer generation goes
+    // through the (possibly lock-based) atomic `std::shared_ptr` load.
+    class Reader
+    {
+    public:
+      explicit Reader(const AtomicConfiguration& source)
+        : _source(&source)
+        , _generation(source.getGeneration())
+        , _snapshot(source.load())
       {}
 
-      // Throws unless the matching constructor was used
-      void setConstraint(const std::vector<int>& choices)
+      // Returns the latest published snapshot; a nullptr if none has been published yet
+      const Snapshot& get()
       {
-        Property::setConstraint(std::make_unique<ConstraintType>(choices));
+        if (std::uint64_t generation = _source->getGeneration(); generation != _generation)
+        {
+          _snapshot = _source->load();
+          _generation = generation;
+        }
+
+        return _snapshot;
       }
 
-      // Throws unless the matching constructor was used
-      void setConstraint(const std::vector<std::string>& choices)
+      const TConfiguration& operator*()
       {
-        Property::setConstraint(std::make_unique<ConstraintType>(choices));
+        return *get();
       }
-    };
-  }
 
-  class JsonProxy;
-
-  class JsonLike
-  {
-  public:
-    virtual ~JsonLike() = default;
+      const TConfiguration* operator->()
+      {
+        return get().get();
+      }
 
-    virtual bool isEmpty() const = 0;
+    private:
+      const AtomicConfiguration* _source;
+      std::uint64_t _generation;
+      Snapshot _snapshot;
+    };
 
-    virtual operator RealType() const = 0;
-    virtual operator StringType() const = 0;
-    virtual operator IntegerType() const = 0;
+    AtomicConfiguration() = default;
 
-    virtual void operator=(const RealType& value) = 0;
-    virtual void operator=(const StringType& value) = 0;
-    virtual void operator=(const IntegerType& value) = 0;
+    explicit AtomicConfiguration(Snapshot snapshot)
+      : _snapshot(std::move(snapshot))
+    {}
 
-    virtual JsonProxy operator[](const std::string& key) const = 0;
-  };
+    AtomicConfiguration(const AtomicConfiguration&) = delete;
+    AtomicConfiguration& operator=(const AtomicConfiguration&) = delete;
 
-  // For not having to directly deal with `std::unique_ptr<JsonLike>`
-  class JsonProxy
-  {
-  public:
-    JsonProxy(std::unique_ptr<JsonLike> json)
-      : _json(std::move(json))
+    Snapshot load() const noexcept
     {
-      if (!_json)
-        throw std::runtime_error("Parameter `json` is a nullptr");
+      return std::atomic_load_explicit(&_snapshot, std::memory_order_acquire);
     }
 
-    JsonProxy operator[](const std::string& key)
+    // Loads the groups of `snapshot` deferred by `Configuration::loadLazy` first, so that readers, which access it
+    // through const accessors only, never modify it; if that fails, nothing is published
+    void publish(Snapshot snapshot)
     {
-      return (*_json)[key];
-    }
+      if (snapshot)
+        snapshot->loadPending();
 
-    // For accessing `JsonLike` members
-    JsonLike* operator->()
-    {
-      return _json.get();
+      std::atomic_store_explicit(&_snapshot, std::move(snapshot), std::memory_order_release);
+      _generation.fetch_add(1, std::memory_order_release);
     }
 
-    // For implicit conversion
-    operator JsonLike& ()
+    // Constructs a `TConfiguration` from `args`, loads it from `json`, validates it and publishes it. If loading
+    // or validation fails, nothing is published and readers keep seeing the previous snapshot.
+    template<class... Args>
+    Snapshot reload(const JsonLike& json, Args&&... args)
     {
-      return *_json;
-    }
+      auto configuration = std::make_shared<TConfiguration>(std::forward<Args>(args)...);
+      *configuration << json;
 
-    // For implicit conversion
-    operator const JsonLike& () const
-    {
-      return *_json;
-    }
+      if (ValidationReport report = configuration->validate(); !report.isValid())
+        throw std::runtime_error(report.getMessage(report.getErrors().front()));
 
-    template<class T>
-    void operator=(const T& value)
-    {
-      *_json = value;
-    }
+      Snapshot snapshot(std::move(configuration));
+      publish(snapshot);
 
-    template<class T>
-    operator T() const
-    {
-      return getValue<T>();
+      return snapshot;
     }
 
-    template<class T>
-    T getValue() const
+    // Incremented on every `publish`
+    std::uint64_t getGeneration() const noexcept
     {
-      if (_json->isEmpty())
-        throw std::runtime_error("Expected this `JsonProxy` to reference a json that contains a value");
-
-      try
-      {
-        return static_cast<T>(*_json);
-      }
-      catch (const std::exception& exc)
-      {
-        // Catching and re-throwing here makes it easier to navigate the stack-trace in case of the exception
-        std::string msg = "Cannot convert the json value held by this `JsonProxy` to the desired type because: ";
-        msg += std::string(exc.what());
-        throw std::runtime_error(msg);
-      }
+      return _generation.load(std::memory_order_acquire);
     }
 
   private:
-    std::unique_ptr<JsonLike> _json;
+    Snapshot _snapshot;
+    std::atomic<std::uint64_t> _generation{ 0 };
   };
 
-  class Group
+  // A property of the snapshots published by an `AtomicConfiguration`, read through a handle cached per thread; safe to
+  // read concurrently, but a reference returned by `get` is only valid until the same thread reads a newer snapshot
+  template<class T, class TConfiguration = Configuration>
+  class CachedProperty
   {
   public:
-    Group(std::string name)
-      : _name{ std::move(name) }
+    CachedProperty(const AtomicConfiguration<TConfiguration>& source, std::string groupName, std::string propertyName)
+      : _source(&source)
+      , _groupName(std::move(groupName))
+      , _propertyName(std::move(propertyName))
+      , _id(nextId())
+      , _slot(acquireSlot(_id))
     {}
 
-    virtual ~Group() = default;
+    CachedProperty(const CachedProperty&) = delete;
+    CachedProperty& operator=(const CachedProperty&) = delete;
 
-  public:
-    const std::string& getName() const noexcept
+    ~CachedProperty()
     {
-      return _name;
+      releaseSlot(_slot);
     }
 
-    virtual void operator<<(const JsonLike& node) = 0;
-    virtual void operator>>(JsonLike& node) const = 0;
+    // Throws if nothing has been published yet, or if the property cannot be resolved (see `PropertyHandle`)
+    const T& get() const
+    {
+      ThreadEntries& cache = threadEntries();
+      std::vector<Entry>& entries = cache.entries;
+      std::uint64_t generation = _source->getGeneration();
 
-  private:
-    std::string _name;
-  };
+      if (_slot < entries.size())
+      {
+        const Entry& entry = entries[_slot];
 
-  template<class>
-  struct less;
+        if (entry.id == _id && entry.generation == generation)
+          return entry.handle.get();
+      }
 
-  template<template<typename> class smart_ptr>
-  struct less<smart_ptr<Group>>
-  {
-    bool operator()(const smart_ptr<Group>& lhs, const smart_ptr<Group>& rhs) const noexcept
+      return refresh(cache, generation);
+    }
+
+    const T& operator*() const
     {
-      return lhs->getName() < rhs->getName();
+      return get();
     }
-  };
 
-  class Configuration : public Group
-  {
-  public:
-    Configuration(std::string name)
-      : Group(std::move(name))
-      , _groups()
-    {}
+  private:
+    // The cache of one thread for the `CachedProperty` with the id `id`; slots of destroyed instances are reused,
+    // ids are not
+    struct Entry
+    {
+      std::uint64_t id = 0;
+      std::uint64_t generation = 0;
+      PropertyHandle<T> handle;
+    };
 
-    bool contains(std::string& name) const
+    struct Slots
     {
-      return findByName(name) != _groups.cend();
-    }
+      std::mutex mutex;
+      std::vector<std::size_t> released;
 
-    bool insert(std::shared_ptr<Group> group, bool silent = false)
+      // The id of the instance holding each slot; 0 while released
+      std::vector<std::uint64_t> owners;
+
+      // Incremented on every release, so that threads can tell when to sweep their entries
+      std::atomic<std::uint64_t> releaseCount{ 0 };
+    };
+
+    struct ThreadEntries
     {
-      auto [other, success] = _groups.insert(std::move(group));
+      std::vector<Entry> entries;
 
-      if (!success && !silent)
-        throw std::runtime_error("Unable to insert `group` with name \"" + (*other)->getName()
-          + "\" because another group with the same name already exists");
+      // `Slots::releaseCount` when `entries` were last swept
+      std::uint64_t releaseCount = 0;
+    };
 
-      return success;
+    static ThreadEntries& threadEntries()
+    {
+      thread_local ThreadEntries entries;
+      return entries;
     }
 
-    std::shared_ptr<Group> remove(const std::string& name, bool silent = false)
+    // Never destroyed, so that instances destroyed in static storage can still release their slots
+    static Slots& slots()
     {
-      std::shared_ptr<Group> group;
-
-      if (auto iter = findByName(name); iter != _groups.cend())
-      {
-        group = *iter;
-        _groups.erase(iter);
-      }
-      else if (!silent)
-        throw std::runtime_error("Unable to remove group by name \"" + name + "\" because it does not exist");
+      static Slots* slots = new Slots();
+      return *slots;
+    }
 
-      return group;
+    static std::uint64_t nextId() noexcept
+    {
+      static std::atomic<std::uint64_t> id{ 0 };
+      return ++id;
     }
 
-    template<class GroupType>
-    std::shared_ptr<GroupType> getTyped(const std::string& name, bool silent = false) const
+    static std::size_t acquireSlot(std::uint64_t id)
     {
-      std::shared_ptr<GroupType> typedGroup;
+      Slots& all = slots();
+      std::lock_guard<std::mutex> lock(all.mutex);
 
-      if (std::shared_ptr<Group> group = get(name, silent); group)
-        typedGroup = std::dynamic_pointer_cast<GroupType>(std::move(group));
+      if (all.released.empty())
+      {
+        // So that `releaseSlot` never allocates
+        all.released.reserve(all.owners.size() + 1);
+        all.owners.push_back(id);
 
-      if (!typedGroup && !silent)
-        throw std::runtime_error("Unable to get group by name \"" + name + "\" in the specified type");
+        return all.owners.size() - 1;
+      }
 
-      return typedGroup;
+      std::size_t slot = all.released.back();
+      all.released.pop_back();
+      all.owners[slot] = id;
+
+      return slot;
     }
 
-    std::shared_ptr<Group> get(const std::string& name, bool silent = false) const
+    static void releaseSlot(std::size_t slot) noexcept
     {
-      std::shared_ptr<Group> group;
-
-      if (auto iter = findByName(name); iter != _groups.cend())
-        group = *iter;
-      else if (!silent)
-        throw std::runtime_error("Cannot get group by name \"" + name + "\" because it does not exist");
+      Slots& all = slots();
+      std::lock_guard<std::mutex> lock(all.mutex);
 
-      return group;
+      all.released.push_back(slot);
+      all.owners[slot] = 0;
+      all.releaseCount.fetch_add(1, std::memory_order_relaxed);
     }
 
-    void operator<<(const JsonLike& json) override final
+    // Releases the handles held for instances destroyed since the last sweep
+    static void sweep(ThreadEntries& cache)
     {
-      JsonProxy thisJson = json[getName()];
+      Slots& all = slots();
+      std::uint64_t releaseCount = all.releaseCount.load(std::memory_order_relaxed);
 
-      if (thisJson->isEmpty())
-        throw std::runtime_error("Expected `json[" + getName() + "]` to contain a value");
+      if (releaseCount == cache.releaseCount)
+        return;
 
-      for (auto& group : _groups)
       {
-        JsonProxy groupJson = thisJson[group->getName()];
+        std::lock_guard<std::mutex> lock(all.mutex);
 
-        if (groupJson->isEmpty())
-          throw std::runtime_error("Expected `json[" + getName() + "][" + group->getName() + "]` to contain a value");
+        for (std::size_t i = 0; i < cache.entries.size(); ++i)
+        {
+          if (cache.entries[i].id != all.owners[i])
+            cache.entries[i].id = 0;
+        }
+      }
 
-        *group << groupJson;
+      // Outside the lock, as this may destroy snapshots
+      for (Entry& entry : cache.entries)
+      {
+        if (entry.id == 0)
+          entry.handle = PropertyHandle<T>();
       }
+
+      cache.releaseCount = releaseCount;
     }
 
-    void operator>>(JsonLike& json) const override final
+    // A snapshot newer than `generation` may be loaded, in which case the next read refreshes again
+    const T& refresh(ThreadEntries& cache, std::uint64_t generation) const
     {
-      JsonProxy thisJson = json[getName()];
+      sweep(cache);
 
-      for (auto& group : _groups)
-      {
-        JsonProxy groupJson = thisJson[group->getName()];
+      std::vector<Entry>& entries = cache.entries;
+      typename AtomicConfiguration<TConfiguration>::Snapshot snapshot = _source->load();
 
-        *group >> groupJson;
-      }
-    }
+      if (!snapshot)
+        throw std::runtime_error("Cannot read property named \"" + _propertyName + "\" because no configuration has been published");
 
-    void operator>>(JsonLike&& temporaryJsonWrapper) const
-    {
-      this->operator>>(temporaryJsonWrapper);
-    }
+      PropertyHandle<T> handle(std::move(snapshot), _groupName, _propertyName);
 
-  protected:
-    std::set<std::shared_ptr<Group>>::const_iterator findByName(const std::string& name) const
-    {
-      auto pred = [&name](const auto& group) { return group->getName() == name; };
-      return std::find_if(_groups.cbegin(), _groups.cend(), pred);
+      if (_slot >= entries.size())
+        entries.resize(_slot + 1);
+
+      Entry& entry = entries[_slot];
+      entry.id = _id;
+      entry.generation = generation;
+      entry.handle = std::move(handle);
+
+      return entry.handle.get();
     }
 
-  private:
-    std::set<std::shared_ptr<Group>, less<std::shared_ptr<Group>>> _groups;
+    const AtomicConfiguration<TConfiguration>* _source;
+    std::string _groupName;
+    std::string _propertyName;
+    std::uint64_t _id;
+    std::size_t _slot;
   };
 } // safeconfig
\ No newline at end of file
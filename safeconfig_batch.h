@@ -0,0 +1,335 @@
+#pragma once
+
+#include "safeconfig.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace safeconfig
+{
+  inline namespace batches
+  {
+    // Bit `i` is set if entry `i` of the validated `NumericBatch` is out of bounds
+    class FailureMask
+    {
+    public:
+      FailureMask() = default;
+
+      explicit FailureMask(std::size_t size)
+        : _words((size + 63) / 64)
+        , _size(size)
+      {}
+
+      std::size_t size() const noexcept
+      {
+        return _size;
+      }
+
+      bool test(std::size_t index) const noexcept
+      {
+        return (_words[index / 64] >> (index % 64)) & 1;
+      }
+
+      // Whether no entry failed
+      bool none() const noexcept
+      {
+        return std::all_of(_words.cbegin(), _words.cend(), [](std::uint64_t word) { return word == 0; });
+      }
+
+      std::size_t count() const noexcept
+      {
+        std::size_t count = 0;
+
+        for (std::uint64_t word : _words)
+        {
+          for (; word != 0; word &= word - 1)
+            ++count;
+        }
+
+        return count;
+      }
+
+      // Calls `visitor(index)` for each failed entry, in ascending order
+      template<class TVisitor>
+      void forEachFailure(TVisitor&& visitor) const
+      {
+        for (std::size_t i = 0; i < _words.size(); ++i)
+        {
+          for (std::uint64_t word = _words[i]; word != 0; word &= word - 1)
+          {
+            std::size_t bit = 0;
+
+            while (!((word >> bit) & 1))
+              ++bit;
+
+            visitor(i * 64 + bit);
+          }
+        }
+      }
+
+      // 64 entries per word, the first entry in the least significant bit
+      const std::vector<std::uint64_t>& getWords() const noexcept
+      {
+        return _words;
+      }
+
+    private:
+      friend class NumericBatch;
+
+      // Sets the bits of `bits` (`count` of them) at `position`
+      void setBits(std::size_t position, std::uint64_t bits, std::size_t count) noexcept
+      {
+        std::size_t word = position / 64;
+        std::size_t shift = position % 64;
+
+        _words[word] |= bits << shift;
+
+        if (shift != 0 && count > 64 - shift)
+          _words[word + 1] |= bits >> (64 - shift);
+      }
+
+      std::vector<std::uint64_t> _words;
+      std::size_t _size = 0;
+    };
+
+    // Numeric values with their bounds, stored in contiguous value, lower and upper bound arrays per value type, so
+    // that `validate` checks them in branch-free loops that compilers vectorize, without the virtual dispatch of
+    // `Constraint::isValid`. Integer entries come first, in the order added, followed by the real entries. A batch
+    // holds copies of the values; it has to be gathered again to validate values that changed since.
+    class NumericBatch
+    {
+    public:
+      // Gathers the numeric properties of `configuration`, including those of nested configurations, by path (as in
+      // `ValidationReport::getPath`); groups deferred by `Configuration::loadLazy` are loaded
+      static NumericBatch gather(const Configuration& configuration)
+      {
+        NumericBatch batch;
+        std::string path;
+        batch.gatherConfiguration(configuration, path);
+
+        return batch;
+      }
+
+      // Returns false, adding nothing, unless `property` has a `NumericConstraint` or `TypedNumericConstraint`
+      bool add(std::string path, const Property& property)
+      {
+        const Constraint& constraint = property.getConstraint();
+
+        if (constraint.getConstraintId() != ConstraintId::numeric)
+          return false;
+
+        const ValueModel& value = property.getValueModel();
+
+        if (auto* numeric = dynamic_cast<const NumericConstraint*>(&constraint))
+        {
+          if (value.getValueId() == ValueId::integer)
+          {
+            addEntries(_integers, _integerSources, std::move(path), &property, &value.getValueUnchecked<IntegerType>(), 1,
+              numeric->getLowerBound<IntegerType>(), numeric->getUpperBound<IntegerType>(), false);
+          }
+          else
+          {
+            addEntries(_reals, _realSources, std::move(path), &property, &value.getValueUnchecked<RealType>(), 1,
+              numeric->getLowerBound<RealType>(), numeric->getUpperBound<RealType>(), false);
+          }
+        }
+        else if (auto* integer = dynamic_cast<const TypedNumericConstraint<IntegerType>*>(&constraint))
+        {
+          addEntries(_integers, _integerSources, std::move(path), &property, &value.getValueUnchecked<IntegerType>(), 1,
+            integer->getLowerBound(), integer->getUpperBound(), false);
+        }
+        else if (auto* real = dynamic_cast<const TypedNumericConstraint<RealType>*>(&constraint))
+        {
+          addEntries(_reals, _realSources, std::move(path), &property, &value.getValueUnchecked<RealType>(), 1,
+            real->getLowerBound(), real->getUpperBound(), false);
+        }
+        else
+        {
+          return false;
+        }
+
+        return true;
+      }
+
+      void add(std::string path, IntegerType value, IntegerType lowerBound, IntegerType upperBound)
+      {
+        addEntries(_integers, _integerSources, std::move(path), nullptr, &value, 1, lowerBound, upperBound, false);
+      }
+
+      void add(std::string path, RealType value, RealType lowerBound, RealType upperBound)
+      {
+        addEntries(_reals, _realSources, std::move(path), nullptr, &value, 1, lowerBound, upperBound, false);
+      }
+
+      // Adds `count` values sharing the same bounds, e.g. the elements of a table; entry `i` has the path "path[i]"
+      void add(std::string path, const IntegerType* values, std::size_t count, IntegerType lowerBound, IntegerType upperBound)
+      {
+        addEntries(_integers, _integerSources, std::move(path), nullptr, values, count, lowerBound, upperBound, true);
+      }
+
+      void add(std::string path, const RealType* values, std::size_t count, RealType lowerBound, RealType upperBound)
+      {
+        addEntries(_reals, _realSources, std::move(path), nullptr, values, count, lowerBound, upperBound, true);
+      }
+
+      std::size_t size() const noexcept
+      {
+        return _integers.values.size() + _reals.values.size();
+      }
+
+      // A value fails if it is not within its bounds (inclusive), as for `NumericConstraint`; NaN always fails
+      FailureMask validate() const
+      {
+        FailureMask mask(size());
+        validateLanes(_integers, 0, mask);
+        validateLanes(_reals, _integers.values.size(), mask);
+
+        return mask;
+      }
+
+      std::string getPath(std::size_t index) const
+      {
+        auto [source, offset] = findSource(index);
+
+        if (!source->isArray)
+          return source->path;
+
+        return source->path + '[' + std::to_string(offset) + ']';
+      }
+
+      // A nullptr unless the entry was added as a property
+      const Property* getProperty(std::size_t index) const
+      {
+        return findSource(index).first->property;
+      }
+
+    private:
+      template<class T>
+      struct Lanes
+      {
+        std::vector<T> values;
+        std::vector<T> lowerBounds;
+        std::vector<T> upperBounds;
+      };
+
+      // One per `add`, in the order of the entries added
+      struct Source
+      {
+        std::string path;
+        const Property* property;
+        std::size_t firstEntry;
+        bool isArray;
+      };
+
+      template<class T>
+      static void addEntries(Lanes<T>& lanes, std::vector<Source>& sources, std::string path, const Property* property,
+        const T* values, std::size_t count, T lowerBound, T upperBound, bool isArray)
+      {
+        if (count == 0)
+          return;
+
+        sources.push_back({ std::move(path), property, lanes.values.size(), isArray });
+
+        lanes.values.insert(lanes.values.end(), values, values + count);
+        lanes.lowerBounds.insert(lanes.lowerBounds.end(), count, lowerBound);
+        lanes.upperBounds.insert(lanes.upperBounds.end(), count, upperBound);
+      }
+
+      template<class T>
+      static void validateLanes(const Lanes<T>& lanes, std::size_t firstEntry, FailureMask& mask)
+      {
+        const T* values = lanes.values.data();
+        const T* lowerBounds = lanes.lowerBounds.data();
+        const T* upperBounds = lanes.upperBounds.data();
+        std::size_t size = lanes.values.size();
+
+        for (std::size_t block = 0; block < size; block += 64)
+        {
+          std::size_t count = std::min<std::size_t>(64, size - block);
+          std::uint8_t failed[64];
+
+          // Branch-free, so that it is vectorized; the comparisons are negated so that NaN fails
+          for (std::size_t i = 0; i < count; ++i)
+          {
+            T value = values[block + i];
+            failed[i] = static_cast<std::uint8_t>(!(value >= lowerBounds[block + i]) | !(value <= upperBounds[block + i]));
+          }
+
+          std::uint64_t bits = 0;
+
+          for (std::size_t i = 0; i < count; ++i)
+            bits |= static_cast<std::uint64_t>(failed[i]) << i;
+
+          if (bits != 0)
+            mask.setBits(firstEntry + block, bits, count);
+        }
+      }
+
+      // Returns the source of the entry at `index`, and the offset of the entry within it
+      std::pair<const Source*, std::size_t> findSource(std::size_t index) const
+      {
+        const std::vector<Source>* sources = &_integerSources;
+
+        if (index >= _integers.values.size())
+        {
+          index -= _integers.values.size();
+          sources = &_realSources;
+        }
+
+        auto iter = std::upper_bound(sources->cbegin(), sources->cend(), index,
+          [](std::size_t entry, const Source& source) { return entry < source.firstEntry; });
+
+        const Source& source = *std::prev(iter);
+
+        return { &source, index - source.firstEntry };
+      }
+
+      void gatherConfiguration(const Configuration& configuration, std::string& path)
+      {
+        std::size_t pathSize = path.size();
+
+        if (!path.empty())
+          path += '/';
+
+        path += configuration.getName();
+
+        configuration.forEachGroup([&](const Group& group)
+          {
+            if (auto* nested = dynamic_cast<const Configuration*>(&group))
+            {
+              gatherConfiguration(*nested, path);
+              return;
+            }
+
+            std::size_t groupPathSize = path.size();
+            path += '/';
+            path += group.getName();
+
+            auto propertyVisitor = [&](const Property& property)
+              {
+                if (property.getConstraint().getConstraintId() == ConstraintId::numeric)
+                  add(path + '/' + property.getName(), property);
+              };
+
+            group.forEachProperty(propertyVisitor);
+
+            path.resize(groupPathSize);
+          }
+        );
+
+        path.resize(pathSize);
+      }
+
+      Lanes<IntegerType> _integers;
+      Lanes<RealType> _reals;
+      std::vector<Source> _integerSources;
+      std::vector<Source> _realSources;
+    };
+  }
+}
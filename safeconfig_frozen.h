@@ -0,0 +1,508 @@
+#pragma once
+
+#include "safeconfig.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace safeconfig
+{
+  inline namespace frozen
+  {
+    // An immutable copy of the values of a configuration, flattened into contiguous arrays indexed by property id:
+    // a value tag and an inline 64-bit value per property (an integer, the bits of a real, or a reference into a
+    // pool of strings), and the index of a descriptor of its constraint. Ids follow the order of the groups and
+    // properties, nested configurations included, as visited by `Configuration::forEachGroup` and
+    // `Group::forEachProperty`. Scans of all values, such as `validate`, `write` and `diff`, are linear passes over
+    // these arrays that neither chase pointers nor make virtual calls.
+    //
+    // Strings are deduplicated in the pool, so that string choices are compared by their reference rather than by
+    // their characters. Values whose constraint is neither a (typed) numeric nor a (typed) choice constraint keep
+    // the validity they had when frozen.
+    class FrozenConfiguration
+    {
+    public:
+      // Throws if a group exposes no properties, as its values could not be flattened
+      explicit FrozenConfiguration(const Configuration& configuration)
+      {
+        std::string path;
+        std::vector<std::uint32_t> segments;
+        freezeConfiguration(configuration, path, segments);
+
+        _sortedIds.resize(size());
+
+        for (std::size_t i = 0; i < _sortedIds.size(); ++i)
+          _sortedIds[i] = static_cast<std::uint32_t>(i);
+
+        std::sort(_sortedIds.begin(), _sortedIds.end(),
+          [this](std::uint32_t lhs, std::uint32_t rhs) { return getPath(lhs) < getPath(rhs); });
+
+        _stringRefs = {};
+        _nameIndices = {};
+        _descriptorIndices = {};
+        _digestDescriptorIndices = {};
+      }
+
+      // Number of properties
+      std::size_t size() const noexcept
+      {
+        return _tags.size();
+      }
+
+      // The id of the property at `path` (as in `ValidationReport::getPath`, e.g. "myConfig/logging/level")
+      std::optional<std::size_t> find(std::string_view path) const
+      {
+        std::optional<std::size_t> id;
+
+        auto iter = std::lower_bound(_sortedIds.cbegin(), _sortedIds.cend(), path,
+          [this](std::uint32_t lhs, std::string_view rhs) { return getPath(lhs) < rhs; });
+
+        if (iter != _sortedIds.cend() && getPath(*iter) == path)
+          id = *iter;
+
+        return id;
+      }
+
+      std::string_view getPath(std::size_t id) const noexcept
+      {
+        std::size_t first = id == 0 ? 0 : _pathEnds[id - 1];
+        return std::string_view(_paths).substr(first, _pathEnds[id] - first);
+      }
+
+      ValueId getValueId(std::size_t id) const noexcept
+      {
+        return _tags[id];
+      }
+
+      // Requires `getValueId(id) == ValueId::integer`
+      IntegerType getInteger(std::size_t id) const noexcept
+      {
+        return static_cast<IntegerType>(static_cast<std::int64_t>(_values[id]));
+      }
+
+      // Requires `getValueId(id) == ValueId::real`
+      RealType getReal(std::size_t id) const noexcept
+      {
+        return realFromBits(_values[id]);
+      }
+
+      // Requires `getValueId(id) == ValueId::string`; valid as long as this configuration
+      std::string_view getString(std::size_t id) const noexcept
+      {
+        return stringFromRef(_values[id]);
+      }
+
+      // Returns the ids of the values that do not pass their constraint, in ascending order
+      std::vector<std::size_t> validate() const
+      {
+        std::vector<std::size_t> invalid;
+
+        for (std::size_t id = 0; id < _tags.size(); ++id)
+        {
+          if (!isValid(id))
+            invalid.push_back(id);
+        }
+
+        return invalid;
+      }
+
+      bool isValid(std::size_t id) const noexcept
+      {
+        const Descriptor& descriptor = _descriptors[_constraints[id]];
+        std::uint64_t value = _values[id];
+
+        if (descriptor.kind != ConstraintKind::opaque && descriptor.valueId != _tags[id])
+          return false;
+
+        bool valid = false;
+
+        switch (descriptor.kind)
+        {
+        case ConstraintKind::integerRange:
+        {
+          auto integer = static_cast<std::int64_t>(value);
+          valid = integer >= descriptor.lower && integer <= descriptor.upper;
+          break;
+        }
+        case ConstraintKind::realRange:
+        {
+          RealType real = realFromBits(value);
+          valid = real >= realFromBits(static_cast<std::uint64_t>(descriptor.lower))
+            && real <= realFromBits(static_cast<std::uint64_t>(descriptor.upper));
+          break;
+        }
+        case ConstraintKind::choices:
+        {
+          // Integers, or references to deduplicated strings, sorted
+          auto first = _choices.cbegin() + static_cast<std::ptrdiff_t>(descriptor.lower);
+          auto last = _choices.cbegin() + static_cast<std::ptrdiff_t>(descriptor.upper);
+          valid = std::binary_search(first, last, value);
+          break;
+        }
+        default:
+          valid = _wasValid[id];
+        }
+
+        return valid;
+      }
+
+      // Writes all values to `json` in id order, as `Configuration::operator>>` would, e.g. to a `JsonTextWriter`;
+      // the members of an object are written in a row, and each object is entered once
+      void write(JsonLike& json) const
+      {
+        std::vector<JsonProxy> objects;
+        std::size_t previousFirst = 0;
+        std::size_t previousDepth = 0;
+
+        for (std::size_t id = 0; id < _tags.size(); ++id)
+        {
+          std::size_t first = _segmentBegins[id];
+          std::size_t depth = _segmentBegins[id + 1] - first - 1;
+
+          // Objects shared with the previous property remain entered
+          std::size_t shared = 0;
+
+          while (shared < depth && shared < previousDepth && _segments[first + shared] == _segments[previousFirst + shared])
+            ++shared;
+
+          while (objects.size() > shared)
+            objects.pop_back();
+
+          for (std::size_t i = shared; i <= depth; ++i)
+          {
+            const std::string& key = _names[_segments[first + i]];
+            objects.push_back(objects.empty() ? json[key] : objects.back()[key]);
+          }
+
+          JsonProxy& value = objects.back();
+
+          switch (_tags[id])
+          {
+          case ValueId::integer:
+            value = getInteger(id);
+            break;
+          case ValueId::real:
+            value = getReal(id);
+            break;
+          default:
+            value = StringType(getString(id));
+          }
+
+          objects.pop_back();
+          previousFirst = first;
+          previousDepth = depth;
+        }
+      }
+
+      void write(JsonLike&& temporaryJsonWrapper) const
+      {
+        write(temporaryJsonWrapper);
+      }
+
+      // Returns the ids of the values that differ from those of `other` (as compared by `ValueModel::operator==`), in
+      // ascending order; throws unless `other` was frozen from a configuration with the same properties
+      std::vector<std::size_t> diff(const FrozenConfiguration& other) const
+      {
+        if (_tags != other._tags || _pathEnds != other._pathEnds || _paths != other._paths)
+          throw std::runtime_error("Cannot diff frozen configurations whose properties differ");
+
+        std::vector<std::size_t> changed;
+
+        for (std::size_t id = 0; id < _tags.size(); ++id)
+        {
+          bool equal = false;
+
+          switch (_tags[id])
+          {
+          case ValueId::integer:
+            equal = _values[id] == other._values[id];
+            break;
+          case ValueId::real:
+            equal = getReal(id) == other.getReal(id);
+            break;
+          default:
+            equal = getString(id) == other.getString(id);
+          }
+
+          if (!equal)
+            changed.push_back(id);
+        }
+
+        return changed;
+      }
+
+    private:
+      enum class ConstraintKind : std::uint8_t
+      {
+        integerRange, // Bounds in `lower` and `upper`
+        realRange,    // Bounds in `lower` and `upper`, as bits
+        choices,      // Sorted choices in `_choices`, from `lower` to `upper`
+        opaque        // Not flattened; see `_wasValid`
+      };
+
+      struct Descriptor
+      {
+        ConstraintKind kind;
+        ValueId valueId;
+        std::int64_t lower;
+        std::int64_t upper;
+      };
+
+      static std::uint64_t bitsFromReal(RealType value) noexcept
+      {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+      }
+
+      static RealType realFromBits(std::uint64_t bits) noexcept
+      {
+        RealType value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+      }
+
+      // A string reference holds the offset of the string in `_strings` in its upper and the size in its lower 32 bits
+      std::string_view stringFromRef(std::uint64_t ref) const noexcept
+      {
+        return std::string_view(_strings).substr(ref >> 32, ref & 0xFFFFFFFF);
+      }
+
+      std::uint64_t internString(std::string_view text)
+      {
+        if (_strings.size() + text.size() > std::numeric_limits<std::uint32_t>::max())
+          throw std::runtime_error("Cannot freeze a configuration whose strings exceed 4 GiB");
+
+        std::uint64_t ref = (static_cast<std::uint64_t>(_strings.size()) << 32) | text.size();
+        auto [iter, isNew] = _stringRefs.emplace(std::string(text), ref);
+
+        if (isNew)
+          _strings.append(text);
+
+        return iter->second;
+      }
+
+      std::uint32_t internName(const std::string& name)
+      {
+        auto [iter, isNew] = _nameIndices.emplace(name, static_cast<std::uint32_t>(_names.size()));
+
+        if (isNew)
+          _names.push_back(name);
+
+        return iter->second;
+      }
+
+      std::uint32_t describeConstraint(const Constraint& constraint)
+      {
+        // Constraints with equal digests accept the same values, and share a descriptor
+        std::uint64_t digest = constraint.getDigest();
+
+        if (digest != 0)
+        {
+          if (auto iter = _digestDescriptorIndices.find(digest); iter != _digestDescriptorIndices.end())
+            return iter->second;
+        }
+        else if (auto iter = _descriptorIndices.find(&constraint); iter != _descriptorIndices.end())
+        {
+          return iter->second;
+        }
+
+        Descriptor descriptor{ ConstraintKind::opaque, constraint.getValueId(), 0, 0 };
+
+        auto describeRange = [&descriptor](auto lower, auto upper)
+          {
+            if constexpr (std::is_same_v<decltype(lower), RealType>)
+            {
+              descriptor.kind = ConstraintKind::realRange;
+              descriptor.lower = static_cast<std::int64_t>(bitsFromReal(lower));
+              descriptor.upper = static_cast<std::int64_t>(bitsFromReal(upper));
+            }
+            else
+            {
+              descriptor.kind = ConstraintKind::integerRange;
+              descriptor.lower = lower;
+              descriptor.upper = upper;
+            }
+          };
+
+        auto describeChoices = [this, &descriptor](const auto& choices)
+          {
+            std::size_t first = _choices.size();
+
+            for (const auto& choice : choices)
+            {
+              if constexpr (std::is_same_v<std::decay_t<decltype(choice)>, InternedString>)
+                _choices.push_back(internString(choice.view()));
+              else
+                _choices.push_back(static_cast<std::uint64_t>(static_cast<std::int64_t>(choice)));
+            }
+
+            std::sort(_choices.begin() + static_cast<std::ptrdiff_t>(first), _choices.end());
+
+            descriptor.kind = ConstraintKind::choices;
+            descriptor.lower = static_cast<std::int64_t>(first);
+            descriptor.upper = static_cast<std::int64_t>(_choices.size());
+          };
+
+        if (auto* numeric = dynamic_cast<const NumericConstraint*>(&constraint))
+        {
+          if (numeric->getValueId() == ValueId::integer)
+            describeRange(numeric->getLowerBound<IntegerType>(), numeric->getUpperBound<IntegerType>());
+          else
+            describeRange(numeric->getLowerBound<RealType>(), numeric->getUpperBound<RealType>());
+        }
+        else if (auto* integerRange = dynamic_cast<const TypedNumericConstraint<IntegerType>*>(&constraint))
+          describeRange(integerRange->getLowerBound(), integerRange->getUpperBound());
+        else if (auto* realRange = dynamic_cast<const TypedNumericConstraint<RealType>*>(&constraint))
+          describeRange(realRange->getLowerBound(), realRange->getUpperBound());
+        else if (auto* choice = dynamic_cast<const ChoiceConstraint*>(&constraint))
+        {
+          if (choice->getValueId() == ValueId::integer)
+            describeChoices(choice->getIntegerChoices());
+          else
+            describeChoices(choice->getStringChoices());
+        }
+        else if (auto* integerChoice = dynamic_cast<const TypedChoiceConstraint<IntegerType>*>(&constraint))
+          describeChoices(integerChoice->getChoices());
+        else if (auto* stringChoice = dynamic_cast<const TypedChoiceConstraint<StringType>*>(&constraint))
+          describeChoices(stringChoice->getChoices());
+
+        auto index = static_cast<std::uint32_t>(_descriptors.size());
+        _descriptors.push_back(descriptor);
+
+        if (digest != 0)
+          _digestDescriptorIndices.emplace(digest, index);
+        else
+          _descriptorIndices.emplace(&constraint, index);
+
+        return index;
+      }
+
+      // `path` and `segments` are those of the enclosing configuration, and are restored on return
+      void freezeConfiguration(const Configuration& configuration, std::string& path, std::vector<std::uint32_t>& segments)
+      {
+        std::size_t pathSize = path.size();
+        std::size_t segmentCount = segments.size();
+
+        if (!path.empty())
+          path += '/';
+
+        path += configuration.getName();
+        segments.push_back(internName(configuration.getName()));
+
+        configuration.forEachGroup([&](const Group& group)
+          {
+            if (auto* nested = dynamic_cast<const Configuration*>(&group))
+            {
+              // A nested configuration appears twice in json, but once in paths
+              segments.push_back(internName(nested->getName()));
+              freezeConfiguration(*nested, path, segments);
+              segments.pop_back();
+              return;
+            }
+
+            std::size_t groupPathSize = path.size();
+            path += '/';
+            path += group.getName();
+            segments.push_back(internName(group.getName()));
+
+            bool exposesProperties = false;
+
+            auto propertyVisitor = [&](const Property& property)
+              {
+                exposesProperties = true;
+                freezeProperty(property, path, segments);
+              };
+
+            group.forEachProperty(propertyVisitor);
+
+            if (!exposesProperties)
+            {
+              throw std::runtime_error("Cannot freeze group \"" + group.getName() + "\" of configuration \""
+                + configuration.getName() + "\" because it exposes no properties");
+            }
+
+            segments.pop_back();
+            path.resize(groupPathSize);
+          }
+        );
+
+        segments.resize(segmentCount);
+        path.resize(pathSize);
+      }
+
+      void freezeProperty(const Property& property, const std::string& groupPath, const std::vector<std::uint32_t>& segments)
+      {
+        const ValueModel& value = property.getValueModel();
+        ValueId valueId = value.getValueId();
+
+        _tags.push_back(valueId);
+
+        switch (valueId)
+        {
+        case ValueId::integer:
+          _values.push_back(static_cast<std::uint64_t>(static_cast<std::int64_t>(value.getValueUnchecked<IntegerType>())));
+          break;
+        case ValueId::real:
+          _values.push_back(bitsFromReal(value.getValueUnchecked<RealType>()));
+          break;
+        default:
+          _values.push_back(internString(value.getValueUnchecked<StringType>()));
+        }
+
+        _constraints.push_back(describeConstraint(property.getConstraint()));
+        _wasValid.push_back(property.isValid());
+
+        _paths += groupPath;
+        _paths += '/';
+        _paths += property.getName();
+        _pathEnds.push_back(_paths.size());
+
+        if (_segmentBegins.empty())
+          _segmentBegins.push_back(0);
+
+        _segments.insert(_segments.end(), segments.cbegin(), segments.cend());
+        _segments.push_back(internName(property.getName()));
+        _segmentBegins.push_back(static_cast<std::uint32_t>(_segments.size()));
+      }
+
+      // Per property
+      std::vector<ValueId> _tags;
+      std::vector<std::uint64_t> _values;
+      std::vector<std::uint32_t> _constraints;
+      std::vector<bool> _wasValid;
+
+      std::string _strings;
+      std::vector<Descriptor> _descriptors;
+      std::vector<std::uint64_t> _choices;
+
+      // The path of property `id` ends at `_pathEnds[id]`, and starts where that of the previous one ends
+      std::string _paths;
+      std::vector<std::size_t> _pathEnds;
+      std::vector<std::uint32_t> _sortedIds;
+
+      // The json keys of property `id`, as indices into `_names`, from `_segmentBegins[id]` to `_segmentBegins[id + 1]`
+      std::vector<std::uint32_t> _segments;
+      std::vector<std::uint32_t> _segmentBegins;
+      std::vector<std::string> _names;
+
+      // Only used while freezing
+      std::unordered_map<std::string, std::uint64_t> _stringRefs;
+      std::unordered_map<std::string, std::uint32_t> _nameIndices;
+      std::unordered_map<const Constraint*, std::uint32_t> _descriptorIndices;
+      std::unordered_map<std::uint64_t, std::uint32_t> _digestDescriptorIndices;
+    };
+  }
+}
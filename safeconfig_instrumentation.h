@@ -0,0 +1,143 @@
+#pragma once
+
+#include "safeconfig.h"
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace safeconfig
+{
+  // Exports the counters maintained if `SAFECONFIG_ENABLE_INSTRUMENTATION` is defined, in the Prometheus text
+  // exposition format. Samples are labeled by path (as in `ValidationReport::getPath`), e.g.
+  //
+  //   safeconfig_property_reads_total{path="myConfig/logging/level"} 42
+  //   safeconfig_group_load_seconds_total{path="myConfig/logging"} 0.000012
+  inline namespace instrumentation
+  {
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+    // Label values escape backslashes, double quotes and line feeds
+    inline void writeInstrumentationLabel(std::ostream& stream, std::string_view path)
+    {
+      stream << "{path=\"";
+
+      for (char c : path)
+      {
+        if (c == '\\' || c == '"')
+          stream << '\\' << c;
+        else if (c == '\n')
+          stream << "\\n";
+        else
+          stream << c;
+      }
+
+      stream << "\"}";
+    }
+
+    // Collects the groups and properties of `configuration` and its nested configurations, without loading
+    // groups deferred by `Configuration::loadLazy`
+    inline void collectInstrumented(const Configuration& configuration, std::string& path,
+      std::vector<std::pair<std::string, const Group*>>& groups,
+      std::vector<std::pair<std::string, const Property*>>& properties)
+    {
+      std::size_t pathSize = path.size();
+
+      if (!path.empty())
+        path += '/';
+
+      path += configuration.getName();
+
+      configuration.forEachGroupWithoutLoading([&](const Group& group)
+        {
+          if (auto* nested = dynamic_cast<const Configuration*>(&group))
+          {
+            groups.emplace_back(path + '/' + group.getName(), &group);
+            collectInstrumented(*nested, path, groups, properties);
+            return;
+          }
+
+          std::size_t groupPathSize = path.size();
+          path += '/';
+          path += group.getName();
+          groups.emplace_back(path, &group);
+
+          auto propertyVisitor = [&](const Property& property)
+            {
+              properties.emplace_back(path + '/' + property.getName(), &property);
+            };
+
+          group.forEachProperty(propertyVisitor);
+
+          path.resize(groupPathSize);
+        }
+      );
+
+      path.resize(pathSize);
+    }
+
+    template<class TSample, class TValue>
+    void writeInstrumentationFamily(std::ostream& stream, const char* name, const char* help,
+      const std::vector<std::pair<std::string, TSample>>& samples, TValue value)
+    {
+      stream << "# HELP " << name << ' ' << help << '\n';
+      stream << "# TYPE " << name << " counter\n";
+
+      for (auto& [path, sample] : samples)
+      {
+        stream << name;
+        writeInstrumentationLabel(stream, path);
+        stream << ' ' << value(*sample) << '\n';
+      }
+    }
+#endif
+
+    // Writes the counters of all groups and properties of `configuration`, including nested configurations, and
+    // the `JsonProxy` counters. Writes only a comment unless instrumentation is enabled.
+    inline void writeInstrumentation(const Configuration& configuration, std::ostream& stream)
+    {
+#ifdef SAFECONFIG_ENABLE_INSTRUMENTATION
+      std::vector<std::pair<std::string, const Group*>> groups;
+      std::vector<std::pair<std::string, const Property*>> properties;
+      std::string path;
+      collectInstrumented(configuration, path, groups, properties);
+
+      auto seconds = [](const Counter& nanoseconds) { return static_cast<double>(nanoseconds.get()) * 1e-9; };
+
+      writeInstrumentationFamily(stream, "safeconfig_property_reads_total", "Reads of the property value.", properties,
+        [](const Property& property) { return property.getCounters().reads.get(); });
+      writeInstrumentationFamily(stream, "safeconfig_property_writes_total", "Writes of the property value.", properties,
+        [](const Property& property) { return property.getCounters().writes.get(); });
+      writeInstrumentationFamily(stream, "safeconfig_property_validations_total", "Constraint checks of a property value.",
+        properties, [](const Property& property) { return property.getCounters().validations.get(); });
+      writeInstrumentationFamily(stream, "safeconfig_property_validation_failures_total",
+        "Constraint checks of a property value that failed.", properties,
+        [](const Property& property) { return property.getCounters().validationFailures.get(); });
+
+      writeInstrumentationFamily(stream, "safeconfig_group_loads_total", "Loads of the group from json.", groups,
+        [](const Group& group) { return group.getCounters().loads.calls.get(); });
+      writeInstrumentationFamily(stream, "safeconfig_group_load_failures_total", "Loads of the group from json that threw.",
+        groups, [](const Group& group) { return group.getCounters().loads.failures.get(); });
+      writeInstrumentationFamily(stream, "safeconfig_group_load_seconds_total", "Time spent loading the group from json.",
+        groups, [&](const Group& group) { return seconds(group.getCounters().loads.nanoseconds); });
+      writeInstrumentationFamily(stream, "safeconfig_group_serializations_total", "Writes of the group to json.", groups,
+        [](const Group& group) { return group.getCounters().serializations.calls.get(); });
+      writeInstrumentationFamily(stream, "safeconfig_group_serialize_failures_total", "Writes of the group to json that threw.",
+        groups, [](const Group& group) { return group.getCounters().serializations.failures.get(); });
+      writeInstrumentationFamily(stream, "safeconfig_group_serialize_seconds_total", "Time spent writing the group to json.",
+        groups, [&](const Group& group) { return seconds(group.getCounters().serializations.nanoseconds); });
+
+      stream << "# HELP safeconfig_json_proxy_heap_adapters_total `JsonLike` adapters held on the heap by `JsonProxy`"
+        " (no other allocations are counted).\n";
+      stream << "# TYPE safeconfig_json_proxy_heap_adapters_total counter\n";
+      stream << "safeconfig_json_proxy_heap_adapters_total " << getJsonProxyCounters().heapAdapters.get() << '\n';
+#else
+      static_cast<void>(configuration);
+      stream << "# safeconfig instrumentation is disabled; define SAFECONFIG_ENABLE_INSTRUMENTATION to enable it\n";
+#endif
+    }
+  }
+}
@@ -0,0 +1,368 @@
+#pragma once
+
+#include "safeconfig.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace safeconfig
+{
+  inline namespace layers
+  {
+    // Composes the values of a configuration from a stack of read-only json layers, ordered from the bottom (e.g.
+    // defaults) to the top (e.g. command line overrides): each property takes its value from the topmost layer that
+    // defines it, and goes back to the value it had when the layers were created if no layer does. Layers are
+    // retained and read in place rather than merged into one document. The resolved values are held by the
+    // properties, and the layer each came from is recorded, so that changing a layer only reads and validates the
+    // keys that layer defines, or defined before. A group that exposes no properties is layered as a whole, and read
+    // by its `operator<<` from the topmost layer that defines it, or from what it wrote by `operator>>` when the
+    // layers were created if no layer does.
+    //
+    // Like `CompiledBinding`, layers refer to the groups and properties present when they were created (groups
+    // deferred by `Configuration::loadLazy` are loaded first, as they would otherwise override the layers), and are not
+    // safe to use concurrently. The documents referred to by a layer (e.g. that of a `NLohmannJsonWrapper`) have to
+    // remain unchanged while the layer is set; to change one, set the layer again.
+    class ConfigurationLayers
+    {
+    public:
+      // A property records the layers defining it in a 64-bit mask
+      static constexpr std::size_t maxLayerCount = 64;
+
+      explicit ConfigurationLayers(Configuration& configuration)
+        : _configuration(&configuration)
+        , _tree(configuration)
+      {
+        configuration.loadPending();
+
+        for (std::size_t index : _tree.getLeaves())
+        {
+          const Node& node = _tree[index];
+          Leaf& leaf = _leaves.emplace_back();
+          leaf.node = index;
+
+          if (node.kind == NodeKind::property)
+          {
+            leaf.baseline = node.property->getValueModel();
+            leaf.isBaselineValid = node.property->isValid();
+          }
+          else
+          {
+            *node.group >> leaf.groupBaseline.emplace();
+          }
+        }
+      }
+
+      std::size_t getLayerCount() const noexcept
+      {
+        return _layers.size();
+      }
+
+      const std::string& getLayerName(std::size_t index) const
+      {
+        return _layers.at(index).name;
+      }
+
+      // Adds a layer on top of the others and returns its index; `json` may be a nullptr for a layer to be set later
+      std::size_t addLayer(std::string name, std::shared_ptr<const JsonLike> json = nullptr)
+      {
+        if (_layers.size() == maxLayerCount)
+        {
+          throw std::runtime_error("Cannot add layer \"" + name + "\" to configuration \"" + _configuration->getName()
+            + "\" because it already has " + std::to_string(maxLayerCount) + " layers");
+        }
+
+        _layers.push_back({ std::move(name), nullptr });
+
+        try
+        {
+          setLayer(_layers.size() - 1, std::move(json));
+        }
+        catch (...)
+        {
+          _layers.pop_back();
+          throw;
+        }
+
+        return _layers.size() - 1;
+      }
+
+      // Replaces the json of the layer at `index` (a nullptr defining nothing), and applies the values that change.
+      // All of them are validated first, and the groups that expose no properties are read all or none (see
+      // `OpaqueGroupLoader`) before any value is applied; on failure nothing is modified, and the messages of all
+      // invalid values, or the error of the group that failed, are thrown in one exception. The attached dispatcher is
+      // notified of the values resolved again.
+      void setLayer(std::size_t index, std::shared_ptr<const JsonLike> json)
+      {
+        Layer& layer = _layers.at(index);
+        const std::uint64_t bit = std::uint64_t(1) << index;
+
+        // The leaves this layer defines from now on, with their json
+        std::vector<std::pair<std::size_t, JsonProxy>> defined;
+
+        if (json)
+          collectDefined(0, *json, defined);
+
+        std::vector<Change> changes;
+        std::string message;
+
+        auto stage = [&](std::size_t leafIndex, std::uint64_t layerMask, JsonProxy* layerJson)
+          {
+            const Leaf& leaf = _leaves[leafIndex];
+            Change change{ leafIndex, layerMask, false, std::nullopt, std::nullopt };
+
+            // The value is unchanged while a layer above this one defines it
+            if (leaf.layerMask >> index >> 1 != 0)
+            {
+              changes.push_back(std::move(change));
+              return;
+            }
+
+            change.isResolved = true;
+            std::size_t source = index;
+
+            if (layerJson)
+            {
+              change.json = std::move(*layerJson);
+            }
+            else if (std::uint64_t below = layerMask & (bit - 1); below != 0)
+            {
+              source = topmostLayer(below);
+              change.json = _tree.findJson(*_layers[source].json, leaf.node);
+            }
+
+            if (stageChange(change, source, message))
+              changes.push_back(std::move(change));
+          };
+
+        // Leaves defined by this layer, and then leaves only defined by its previous json, which fall back to the
+        // layers below
+        std::size_t next = 0;
+
+        std::sort(defined.begin(), defined.end(),
+          [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+        for (std::size_t i = 0; i < _leaves.size(); ++i)
+        {
+          bool isDefined = next < defined.size() && defined[next].first == i;
+
+          if (isDefined)
+            stage(i, _leaves[i].layerMask | bit, &defined[next++].second);
+          else if (_leaves[i].layerMask & bit)
+            stage(i, _leaves[i].layerMask & ~bit, nullptr);
+        }
+
+        if (!message.empty())
+        {
+          throw std::runtime_error("Cannot set layer \"" + layer.name + "\" of configuration \""
+            + _configuration->getName() + '"' + message);
+        }
+
+        // Groups that expose no properties first, as reading them may throw; those no layer defines any longer go
+        // back to their baseline
+        OpaqueGroupLoader loader;
+        std::vector<const Node*> loaded;
+
+        for (Change& change : changes)
+        {
+          const Leaf& leaf = _leaves[change.leaf];
+          const Node& node = _tree[leaf.node];
+
+          if (change.isResolved && node.kind == NodeKind::opaqueGroup)
+          {
+            loader.add(*node.group, change.json ? static_cast<const JsonLike&>(*change.json) : *leaf.groupBaseline);
+            loaded.push_back(&node);
+          }
+        }
+
+        try
+        {
+          loader.load();
+        }
+        catch (const std::exception& exception)
+        {
+          throw std::runtime_error("Cannot set layer \"" + layer.name + "\" of configuration \""
+            + _configuration->getName() + "\"\n  `" + loaded[loader.getFailedIndex()]->path + "`: " + exception.what());
+        }
+
+        ChangeDispatcher* dispatcher = _configuration->getDispatcher();
+        ChangeSet applied;
+
+        for (Change& change : changes)
+        {
+          Leaf& leaf = _leaves[change.leaf];
+          const Node& node = _tree[leaf.node];
+
+          if (change.isResolved && node.kind == NodeKind::property)
+          {
+            if (change.value)
+              node.property->setValueModelUnchecked(std::move(*change.value));
+            else
+              node.property->setValueModelUnchecked(*leaf.baseline, leaf.isBaselineValid);
+          }
+
+          if (change.isResolved && dispatcher)
+            applied.add(node.path, *node.group, node.property);
+
+          leaf.layerMask = change.layerMask;
+        }
+
+        layer.json = std::move(json);
+
+        if (dispatcher)
+          dispatcher->dispatch(applied);
+      }
+
+      // The index of the layer the value at `path` (as in `ValidationReport::getPath`, e.g. "myConfig/logging/level",
+      // or the path of a group that exposes no properties) comes from; empty if no layer defines it, or if there is
+      // no such value
+      std::optional<std::size_t> findSource(std::string_view path) const
+      {
+        std::optional<std::size_t> source;
+
+        auto iter = std::find_if(_leaves.cbegin(), _leaves.cend(),
+          [&](const Leaf& leaf) { return _tree[leaf.node].path == path; });
+
+        if (iter != _leaves.cend() && iter->layerMask != 0)
+          source = topmostLayer(iter->layerMask);
+
+        return source;
+      }
+
+    private:
+      using NodeKind = ConfigurationTree::NodeKind;
+      using Node = ConfigurationTree::Node;
+
+      struct Leaf
+      {
+        // Into `_tree`
+        std::size_t node = 0;
+
+        // Bit `i` is set if layer `i` defines this value
+        std::uint64_t layerMask = 0;
+
+        // For a property, the value it takes while no layer defines it
+        std::optional<ValueModel> baseline;
+        bool isBaselineValid = true;
+
+        // For a group that exposes no properties, the json it reads while no layer defines it
+        std::optional<JsonTree> groupBaseline;
+      };
+
+      struct Layer
+      {
+        std::string name;
+        std::shared_ptr<const JsonLike> json;
+      };
+
+      // Of the leaf at `leaf`, staged by `setLayer`
+      struct Change
+      {
+        std::size_t leaf;
+        std::uint64_t layerMask;
+
+        // False if a layer above the one set defines the leaf, in which case only `layerMask` changes
+        bool isResolved;
+
+        // Empty if no layer defines the leaf any longer
+        std::optional<JsonProxy> json;
+        std::optional<ValueModel> value;
+      };
+
+      static std::size_t topmostLayer(std::uint64_t layerMask) noexcept
+      {
+        std::size_t layer = maxLayerCount - 1;
+
+        while (!((layerMask >> layer) & 1))
+          --layer;
+
+        return layer;
+      }
+
+      // Collects the leaves below the node at `index`, an object, that `json` defines; members that are not layered
+      // are skipped
+      void collectDefined(std::size_t index, const JsonLike& json, std::vector<std::pair<std::size_t, JsonProxy>>& defined)
+      {
+        auto collect = [&](std::size_t child, JsonProxy& member)
+          {
+            if (member->isEmpty())
+              return;
+
+            const Node& node = _tree[child];
+
+            if (node.isLeaf())
+              defined.emplace_back(node.leaf, std::move(member));
+            else
+              collectDefined(child, member, defined);
+          };
+
+        std::size_t first = _tree[index].firstChild;
+        std::size_t last = first + _tree[index].childCount;
+
+        auto visitor = [&](const std::string& key, JsonProxy& member)
+          {
+            if (std::size_t child = _tree.findChild(index, key); child != 0)
+              collect(child, member);
+
+            return true;
+          };
+
+        if (json.forEachMember(std::ref(visitor)))
+          return;
+
+        for (std::size_t child = first; child < last; ++child)
+        {
+          if (std::optional<JsonProxy> member = json.find(_tree[child].key))
+            collect(child, *member);
+        }
+      }
+
+      // Reads and validates the value of `change` from layer `layer`, unless no layer defines it or it is the json of a
+      // group that exposes no properties; appends to `message` and returns false on failure
+      bool stageChange(Change& change, std::size_t layer, std::string& message) const
+      {
+        const Node& node = _tree[_leaves[change.leaf].node];
+
+        // A group that exposes no properties can only be checked by reading it
+        if (!change.json || node.kind == NodeKind::opaqueGroup)
+          return true;
+
+        std::string source = "` of layer \"" + _layers[layer].name + '"';
+
+        const Property& property = *node.property;
+        change.value = (*change.json)->toValueModel(property.getValueId());
+        change.json.reset();
+
+        if (!change.value)
+        {
+          message += "\n  Expected `" + node.path + source + " to contain a value of type `"
+            + valueNameFromValueId(property.getValueId()) + '`';
+          return false;
+        }
+
+        if (!property.accepts(*change.value))
+        {
+          message += "\n  Value of `" + node.path + source + " is invalid";
+          return false;
+        }
+
+        return true;
+      }
+
+      Configuration* _configuration;
+      ConfigurationTree _tree;
+
+      // Per leaf of `_tree`
+      std::vector<Leaf> _leaves;
+      std::vector<Layer> _layers;
+    };
+  }
+}
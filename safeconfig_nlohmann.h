@@ -0,0 +1,562 @@
+#pragma once
+
+#include "safeconfig.h"
+#include "nlohmann_json.h"
+
+#include <exception>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace safeconfig
+{
+  // Adapts a node of a `nlohmann::json` document to `JsonLike`
+  class NLohmannJsonWrapper : public JsonLike
+  {
+  public:
+    NLohmannJsonWrapper(nlohmann::json& json)
+      : _json(json)
+    {
+    }
+
+    JsonProxy operator[](const std::string& key) const override
+    {
+      return { std::in_place_type<NLohmannJsonWrapper>, _json[key] };
+    }
+
+    std::optional<JsonProxy> find(const std::string& key) const override
+    {
+      std::optional<JsonProxy> json;
+
+      if (_json.is_object())
+      {
+        if (auto iter = _json.find(key); iter != _json.end() && !iter->is_null())
+          json.emplace(std::in_place_type<NLohmannJsonWrapper>, *iter);
+      }
+
+      return json;
+    }
+
+    // The members of a `nlohmann::json` object are ordered by key
+    bool forEachMember(const std::function<bool(const std::string&, JsonProxy&)>& visitor) const override
+    {
+      if (_json.is_object())
+      {
+        for (auto iter = _json.begin(); iter != _json.end(); ++iter)
+        {
+          JsonProxy member(std::in_place_type<NLohmannJsonWrapper>, *iter);
+
+          if (!visitor(iter.key(), member))
+            break;
+        }
+      }
+
+      return true;
+    }
+
+    bool isEmpty() const override
+    {
+      return _json.is_null();
+    }
+
+    bool holds(ValueId id) const override
+    {
+      bool holds = false;
+
+      switch (id)
+      {
+      case ValueId::integer:
+        if (_json.is_number_unsigned())
+          holds = _json.get<std::uint64_t>() <= static_cast<std::uint64_t>(std::numeric_limits<IntegerType>::max());
+        else if (_json.is_number_integer())
+          holds = isInRange(_json.get<std::int64_t>());
+        break;
+      case ValueId::real:
+        holds = _json.is_number();
+        break;
+      case ValueId::string:
+        holds = _json.is_string();
+        break;
+      default:
+      {
+        // Pass
+      }
+      }
+
+      return holds;
+    }
+
+    std::optional<std::string_view> viewString() const override
+    {
+      std::optional<std::string_view> value;
+
+      if (_json.is_string())
+        value = _json.get_ref<const std::string&>();
+
+      return value;
+    }
+
+    operator int() const override
+    {
+      return static_cast<int>(_json);
+    }
+
+    operator double() const override
+    {
+      return static_cast<double>(_json);
+    }
+
+    operator std::string() const override
+    {
+      return static_cast<std::string>(_json);
+    }
+
+    void operator=(const int& value) override
+    {
+      _json = value;
+    }
+
+    void operator=(const double& value) override
+    {
+      _json = value;
+    }
+
+    void operator=(const std::string& value) override
+    {
+      _json = value;
+    }
+
+  private:
+    static bool isInRange(std::int64_t value) noexcept
+    {
+      return value >= std::numeric_limits<IntegerType>::min() && value <= std::numeric_limits<IntegerType>::max();
+    }
+
+    nlohmann::json& _json;
+  };
+
+  // Populates a `Configuration` straight from json parse events, without building a DOM of the document.
+  // Values are routed to the properties that groups expose (see `Group::forEachProperty`) as they are parsed,
+  // and subtrees that no group consumes are skipped without being materialized. A group that exposes no
+  // properties is read by its `operator<<` from a DOM of only its own subtree. Like `Configuration::operator<<`,
+  // loading requires a value for each group and exposed property, stops at the first error, leaving values read
+  // up to that point applied, and notifies the attached dispatcher of a change of the whole configuration. Groups
+  // deferred by `Configuration::loadLazy` are superseded without being loaded.
+  class StreamingLoader : public nlohmann::json_sax<nlohmann::json>
+  {
+    using Json = nlohmann::json;
+
+  public:
+    explicit StreamingLoader(Configuration& configuration)
+      : _configuration(configuration)
+    {}
+
+    // `input` is anything accepted by `nlohmann::json::sax_parse`, e.g. a `std::istream&` or a string
+    template<class Input>
+    void load(Input&& input)
+    {
+      _frames.clear();
+      _seen.clear();
+      _error = nullptr;
+      _next = { TargetKind::wrapper, &_configuration, &_configuration, nullptr };
+      _bufferDepth = 0;
+      _bufferStack.clear();
+      _buffer = nullptr;
+      _bufferKey.clear();
+
+      try
+      {
+        {
+          ChangeDispatcher::Suspension suspension;
+          Json::sax_parse(std::forward<Input>(input), this);
+        }
+
+        if (_error)
+          std::rethrow_exception(_error);
+
+        assertComplete(_configuration);
+      }
+      catch (...)
+      {
+        _configuration.notifyReloaded();
+        throw;
+      }
+
+      // Superseded
+      _configuration.discardLazyGroups();
+      _configuration.notifyReloaded();
+    }
+
+    bool null() override
+    {
+      if (isBuffering() || _next.kind == TargetKind::buffer)
+        return bufferValue(nullptr);
+
+      return true; // A null counts as a missing value
+    }
+
+    bool boolean(bool value) override
+    {
+      if (isBuffering() || _next.kind == TargetKind::buffer)
+        return bufferValue(value);
+
+      return assign(ValueId::unknown, [] {});
+    }
+
+    bool number_integer(number_integer_t value) override
+    {
+      if (isBuffering() || _next.kind == TargetKind::buffer)
+        return bufferValue(value);
+
+      return assignInteger(value);
+    }
+
+    bool number_unsigned(number_unsigned_t value) override
+    {
+      if (isBuffering() || _next.kind == TargetKind::buffer)
+        return bufferValue(value);
+
+      return assignInteger(value);
+    }
+
+    bool number_float(number_float_t value, const string_t&) override
+    {
+      if (isBuffering() || _next.kind == TargetKind::buffer)
+        return bufferValue(value);
+
+      return assign(ValueId::real, [this, value] { _next.property->setValue(static_cast<RealType>(value)); });
+    }
+
+    bool string(string_t& value) override
+    {
+      if (isBuffering() || _next.kind == TargetKind::buffer)
+        return bufferValue(std::move(value));
+
+      return assign(ValueId::string, [this, &value] { _next.property->setValue(std::move(value)); });
+    }
+
+    bool binary(binary_t& value) override
+    {
+      if (isBuffering() || _next.kind == TargetKind::buffer)
+        return bufferValue(Json::binary(value));
+
+      return assign(ValueId::unknown, [] {});
+    }
+
+    bool start_object(std::size_t) override
+    {
+      if (isBuffering() || _next.kind == TargetKind::buffer)
+        return bufferStart(Json::object());
+
+      if (_next.kind == TargetKind::property)
+        return assign(ValueId::unknown, [] {});
+
+      if (_next.kind == TargetKind::configuration || _next.kind == TargetKind::group)
+        _seen.insert(_next.group);
+
+      _frames.push_back(_next);
+      _next = {};
+      return true;
+    }
+
+    bool key(string_t& key) override
+    {
+      if (isBuffering())
+      {
+        _bufferKey = std::move(key);
+        return true;
+      }
+
+      _next = {};
+
+      if (_frames.empty())
+        return true;
+
+      const Target& frame = _frames.back();
+
+      switch (frame.kind)
+      {
+      case TargetKind::wrapper:
+        if (key == frame.group->getName())
+          _next = { TargetKind::configuration, frame.configuration, frame.configuration, nullptr };
+        break;
+      case TargetKind::configuration:
+        if (std::shared_ptr<Group> group = frame.configuration->getWithoutLoading(key); group)
+          _next = targetFromGroup(*group);
+        break;
+      case TargetKind::group:
+        if (Property* property = frame.group->findProperty(key); property)
+          _next = { TargetKind::property, nullptr, frame.group, property };
+        break;
+      default:
+      {
+        // Pass
+      }
+      }
+
+      return true;
+    }
+
+    bool end_object() override
+    {
+      return end();
+    }
+
+    bool start_array(std::size_t) override
+    {
+      if (isBuffering() || _next.kind == TargetKind::buffer)
+        return bufferStart(Json::array());
+
+      if (_next.kind == TargetKind::property)
+        return assign(ValueId::unknown, [] {});
+
+      _frames.push_back({});
+      _next = {};
+      return true;
+    }
+
+    bool end_array() override
+    {
+      return end();
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& exc) override
+    {
+      _error = std::make_exception_ptr(std::runtime_error(std::string("Cannot parse json because: ") + exc.what()));
+      return false;
+    }
+
+  private:
+    enum class TargetKind
+    {
+      skip,          // Not consumed
+      wrapper,       // An object holding `configuration` by its name (see `Configuration::operator<<`)
+      configuration, // An object holding the groups of `configuration` by their names
+      group,         // An object holding the properties exposed by `group` by their names
+      property,      // The value of `property`
+      buffer         // The json read by `group` through its `operator<<`
+    };
+
+    struct Target
+    {
+      TargetKind kind = TargetKind::skip;
+      Configuration* configuration = nullptr;
+      Group* group = nullptr;
+      Property* property = nullptr;
+    };
+
+    static Target targetFromGroup(Group& group)
+    {
+      Target target;
+
+      if (auto* configuration = dynamic_cast<Configuration*>(&group); configuration)
+      {
+        target = { TargetKind::wrapper, configuration, configuration, nullptr };
+      }
+      else
+      {
+        bool exposesProperties = false;
+        group.forEachProperty([&exposesProperties](Property&) { exposesProperties = true; });
+
+        target = { exposesProperties ? TargetKind::group : TargetKind::buffer, nullptr, &group, nullptr };
+      }
+
+      return target;
+    }
+
+    bool isBuffering() const noexcept
+    {
+      return _bufferDepth > 0;
+    }
+
+    template<class Func>
+    bool tryInvoke(Func&& func)
+    {
+      try
+      {
+        func();
+      }
+      catch (...)
+      {
+        _error = std::current_exception();
+      }
+
+      return !_error;
+    }
+
+    // Assigns a value that can be read as the type `valueId` to the property awaiting a value, if any
+    template<class Assign>
+    bool assign(ValueId valueId, Assign&& assignValue)
+    {
+      if (_next.kind != TargetKind::property)
+        return true;
+
+      Property& property = *_next.property;
+
+      return tryInvoke([&]
+        {
+          if (valueId != property.getValueId() && !(valueId == ValueId::integer && property.getValueId() == ValueId::real))
+          {
+            throw std::runtime_error("Expected `json[" + property.getName() + "]` to contain a value of type `"
+              + valueNameFromValueId(property.getValueId()) + '`');
+          }
+
+          _seen.insert(&property);
+          assignValue();
+        }
+      );
+    }
+
+    // An integer out of the range of `IntegerType` can only be read as a real, like `NLohmannJsonWrapper::holds`
+    template<class T>
+    bool assignInteger(T value)
+    {
+      bool isInRange;
+
+      if constexpr (std::is_signed_v<T>)
+        isInRange = value >= std::numeric_limits<IntegerType>::min() && value <= std::numeric_limits<IntegerType>::max();
+      else
+        isInRange = value <= static_cast<std::uint64_t>(std::numeric_limits<IntegerType>::max());
+
+      if (!isInRange)
+        return assign(ValueId::real, [this, value] { _next.property->setValue(static_cast<RealType>(value)); });
+
+      return assign(ValueId::integer, [this, value]
+        {
+          if (_next.property->getValueId() == ValueId::real)
+            _next.property->setValue(static_cast<RealType>(value));
+          else
+            _next.property->setValue(static_cast<IntegerType>(value));
+        }
+      );
+    }
+
+    bool end()
+    {
+      if (isBuffering())
+      {
+        _bufferStack.pop_back();
+
+        if (--_bufferDepth == 0)
+          return finishBuffer();
+
+        return true;
+      }
+
+      if (!_frames.empty())
+        _frames.pop_back();
+
+      _next = {};
+      return true;
+    }
+
+    bool bufferStart(Json container)
+    {
+      Json* json = bufferInsert(std::move(container));
+      _bufferStack.push_back(json);
+      ++_bufferDepth;
+      return true;
+    }
+
+    bool bufferValue(Json value)
+    {
+      bufferInsert(std::move(value));
+      return isBuffering() || finishBuffer();
+    }
+
+    Json* bufferInsert(Json value)
+    {
+      Json* json;
+
+      if (_bufferStack.empty())
+      {
+        _buffer = std::move(value);
+        json = &_buffer;
+      }
+      else if (Json& parent = *_bufferStack.back(); parent.is_object())
+      {
+        json = &(parent[_bufferKey] = std::move(value));
+      }
+      else
+      {
+        parent.push_back(std::move(value));
+        json = &parent.back();
+      }
+
+      return json;
+    }
+
+    bool finishBuffer()
+    {
+      Group& group = *_next.group;
+      _next = {};
+
+      if (_buffer.is_null())
+        return true;
+
+      return tryInvoke([this, &group]
+        {
+          group << NLohmannJsonWrapper(_buffer);
+          _seen.insert(&group);
+          _buffer = nullptr;
+        }
+      );
+    }
+
+    // Throws for the first value required by `Configuration::operator<<` that was not loaded
+    void assertComplete(const Configuration& configuration) const
+    {
+      if (!_seen.count(static_cast<const Group*>(&configuration)))
+        throw std::runtime_error("Expected `json[" + configuration.getName() + "]` to contain a value");
+
+      configuration.forEachGroupWithoutLoading([this, &configuration](const Group& group)
+        {
+          if (auto* nested = dynamic_cast<const Configuration*>(&group); nested)
+          {
+            assertComplete(*nested);
+          }
+          else if (!_seen.count(&group))
+          {
+            throw std::runtime_error("Expected `json[" + configuration.getName() + "][" + group.getName()
+              + "]` to contain a value");
+          }
+
+          group.forEachProperty([this](const Property& property)
+            {
+              if (!_seen.count(&property))
+                throw std::runtime_error("Expected `json[" + property.getName() + "]` to contain a value");
+            }
+          );
+        }
+      );
+    }
+
+    Configuration& _configuration;
+
+    // Containers currently open (outside of a buffered subtree), and what their values are routed to
+    std::vector<Target> _frames;
+
+    // What the next value is routed to
+    Target _next;
+
+    // Configurations, groups and properties that a value was read for
+    std::unordered_set<const void*> _seen;
+
+    std::exception_ptr _error;
+
+    // DOM of the subtree being read for a group that exposes no properties
+    Json _buffer;
+    std::vector<Json*> _bufferStack;
+    std::string _bufferKey;
+    std::size_t _bufferDepth = 0;
+  };
+} // safeconfig
@@ -0,0 +1,539 @@
+#pragma once
+
+#include "safeconfig.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>) && __has_include(<sys/stat.h>) && __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SAFECONFIG_HAS_MMAP 1
+#endif
+
+namespace safeconfig
+{
+  // A binary snapshot holds the values of all properties of a configuration, keyed by their paths (as in
+  // `ValidationReport::getPath`) and tagged with their `ValueId`. All integers are in the byte order of the
+  // writer, which is recorded and checked by the reader:
+  //
+  //   header   magic[8], version, byteOrder, schemaDigest (64-bit), entryCount, stringsOffset, stringsSize, 0
+  //   entries  entryCount x { pathOffset, pathSize, valueId, valueSize, value (64-bit) }, sorted by path
+  //   strings  the paths and string values, referenced by offset from `stringsOffset`
+  //
+  // An entry's `value` is an integer, the bits of a real, or the offset of a string of `valueSize` bytes.
+  inline namespace snapshots
+  {
+    inline constexpr char snapshotMagic[8] = { 'S', 'A', 'F', 'E', 'C', 'F', 'G', '\0' };
+    inline constexpr std::uint32_t snapshotVersion = 1;
+    inline constexpr std::uint32_t snapshotByteOrder = 0x01020304;
+    inline constexpr std::size_t snapshotHeaderSize = 40;
+    inline constexpr std::size_t snapshotEntrySize = 24;
+
+    // Calls `visitor(path, property)` for each property in `configuration`, including those of nested
+    // configurations; throws if a group exposes no properties, as its values could not be captured. Groups deferred
+    // by `Configuration::loadLazy` are loaded first unless `loadPending` is false.
+    template<class TVisitor>
+    void visitSnapshotProperties(const Configuration& configuration, std::string& path, TVisitor& visitor,
+      bool loadPending = true)
+    {
+      std::size_t pathSize = path.size();
+
+      if (!path.empty())
+        path += '/';
+
+      path += configuration.getName();
+
+      auto groupVisitor = [&](const Group& group)
+        {
+          if (auto* nested = dynamic_cast<const Configuration*>(&group))
+          {
+            visitSnapshotProperties(*nested, path, visitor, loadPending);
+            return;
+          }
+
+          std::size_t groupPathSize = path.size();
+          path += '/';
+          path += group.getName();
+
+          bool exposesProperties = false;
+
+          auto propertyVisitor = [&](const Property& property)
+            {
+              exposesProperties = true;
+
+              std::size_t propertyPathSize = path.size();
+              path += '/';
+              path += property.getName();
+
+              visitor(static_cast<const std::string&>(path), property);
+
+              path.resize(propertyPathSize);
+            };
+
+          group.forEachProperty(propertyVisitor);
+
+          if (!exposesProperties)
+            throw std::runtime_error("Cannot snapshot `" + path + "` because the group exposes no properties");
+
+          path.resize(groupPathSize);
+        };
+
+      if (loadPending)
+        configuration.forEachGroup(groupVisitor);
+      else
+        configuration.forEachGroupWithoutLoading(groupVisitor);
+
+      path.resize(pathSize);
+    }
+
+    // Digest of the paths, value types and constraints of all properties in `configuration`; 0 if a constraint
+    // provides no digest
+    inline std::uint64_t computeSchemaDigest(const Configuration& configuration)
+    {
+      Digest digest;
+      bool isComplete = true;
+      std::string path;
+
+      auto visitor = [&](const std::string& propertyPath, const Property& property)
+        {
+          std::uint64_t constraintDigest = property.getConstraint().getDigest();
+          isComplete = isComplete && constraintDigest != 0;
+
+          digest.add(propertyPath);
+          digest.add(property.getValueId());
+          digest.add(constraintDigest);
+        };
+
+      visitSnapshotProperties(configuration, path, visitor);
+
+      return isComplete ? digest.get() : 0;
+    }
+
+    // Read-only access to a snapshot held in memory (e.g. mapped from a file); does not copy the data, which
+    // must outlive the view. The layout is checked on construction, so that reads need no further checks.
+    class SnapshotView
+    {
+    public:
+      class Entry
+      {
+      public:
+        std::string_view getPath() const noexcept
+        {
+          return _view->string(_view->read<std::uint32_t>(_offset), _view->read<std::uint32_t>(_offset + 4));
+        }
+
+        ValueId getValueId() const noexcept
+        {
+          return static_cast<ValueId>(_view->read<std::uint32_t>(_offset + 8));
+        }
+
+        // `T` is `IntegerType`, `RealType` or `std::string_view`; the latter refers into the snapshot
+        template<class T>
+        T getValue() const
+        {
+          constexpr ValueId valueId = std::is_same_v<T, std::string_view> ? ValueId::string : valueIdFromValueType<T>;
+          static_assert(valueId != ValueId::unknown);
+
+          if (getValueId() != valueId)
+          {
+            throw std::runtime_error("Expected snapshot entry `" + std::string(getPath()) + "` to contain a value of type `"
+              + valueNameFromValueId(valueId) + '`');
+          }
+
+          if constexpr (valueId == ValueId::integer)
+            return static_cast<IntegerType>(_view->read<std::int64_t>(_offset + 16));
+          else if constexpr (valueId == ValueId::real)
+            return _view->read<RealType>(_offset + 16);
+          else
+            return _view->string(_view->read<std::uint64_t>(_offset + 16), _view->read<std::uint32_t>(_offset + 12));
+        }
+
+        ValueModel toValueModel() const
+        {
+          ValueModel value(getValueId());
+
+          switch (getValueId())
+          {
+          case ValueId::integer:
+            value.setValueUnchecked(getValue<IntegerType>());
+            break;
+          case ValueId::real:
+            value.setValueUnchecked(getValue<RealType>());
+            break;
+          case ValueId::string:
+            value.setValueUnchecked(StringType(getValue<std::string_view>()));
+            break;
+          default:
+            throw std::runtime_error("Not implemented");
+          }
+
+          return value;
+        }
+
+      private:
+        friend class SnapshotView;
+
+        Entry(const SnapshotView& view, std::size_t offset) noexcept
+          : _view(&view)
+          , _offset(offset)
+        {}
+
+        const SnapshotView* _view;
+        std::size_t _offset;
+      };
+
+      SnapshotView(const void* data, std::size_t size)
+        : _data(static_cast<const char*>(data))
+      {
+        if (size < snapshotHeaderSize || std::memcmp(_data, snapshotMagic, sizeof(snapshotMagic)) != 0)
+          throw std::runtime_error("Data is not a configuration snapshot");
+
+        if (read<std::uint32_t>(8) != snapshotVersion)
+          throw std::runtime_error("Unsupported configuration snapshot version " + std::to_string(read<std::uint32_t>(8)));
+
+        if (read<std::uint32_t>(12) != snapshotByteOrder)
+          throw std::runtime_error("Configuration snapshot was written with a different byte order");
+
+        _entryCount = read<std::uint32_t>(24);
+        _stringsOffset = read<std::uint32_t>(28);
+        _stringsSize = read<std::uint32_t>(32);
+
+        if (_stringsOffset < snapshotHeaderSize + _entryCount * snapshotEntrySize || _stringsOffset > size
+          || _stringsSize > size - _stringsOffset)
+          throw std::runtime_error("Configuration snapshot is truncated or corrupt");
+
+        for (std::size_t i = 0; i < _entryCount; ++i)
+        {
+          std::size_t offset = entryOffset(i);
+          bool isValid = fitsStrings(read<std::uint32_t>(offset), read<std::uint32_t>(offset + 4));
+
+          switch (static_cast<ValueId>(read<std::uint32_t>(offset + 8)))
+          {
+          case ValueId::integer:
+          case ValueId::real:
+            break;
+          case ValueId::string:
+            isValid = isValid && fitsStrings(read<std::uint64_t>(offset + 16), read<std::uint32_t>(offset + 12));
+            break;
+          default:
+            isValid = false;
+          }
+
+          if (!isValid)
+            throw std::runtime_error("Configuration snapshot is truncated or corrupt");
+        }
+      }
+
+      // As computed by `computeSchemaDigest` for the configuration the snapshot was taken of
+      std::uint64_t getSchemaDigest() const noexcept
+      {
+        return read<std::uint64_t>(16);
+      }
+
+      std::size_t size() const noexcept
+      {
+        return _entryCount;
+      }
+
+      Entry operator[](std::size_t index) const noexcept
+      {
+        return Entry(*this, entryOffset(index));
+      }
+
+      // Binary search by path
+      std::optional<Entry> find(std::string_view path) const noexcept
+      {
+        std::size_t begin = 0;
+        std::size_t end = _entryCount;
+
+        while (begin < end)
+        {
+          std::size_t middle = begin + (end - begin) / 2;
+
+          if ((*this)[middle].getPath() < path)
+            begin = middle + 1;
+          else
+            end = middle;
+        }
+
+        std::optional<Entry> entry;
+
+        if (begin < _entryCount && (*this)[begin].getPath() == path)
+          entry.emplace((*this)[begin]);
+
+        return entry;
+      }
+
+    private:
+      // Unaligned reads, as the data is not required to be aligned
+      template<class T>
+      T read(std::size_t offset) const noexcept
+      {
+        T value;
+        std::memcpy(&value, _data + offset, sizeof(T));
+        return value;
+      }
+
+      std::string_view string(std::uint64_t offset, std::uint32_t size) const noexcept
+      {
+        return std::string_view(_data + _stringsOffset + offset, size);
+      }
+
+      bool fitsStrings(std::uint64_t offset, std::uint32_t size) const noexcept
+      {
+        return offset <= _stringsSize && size <= _stringsSize - offset;
+      }
+
+      std::size_t entryOffset(std::size_t index) const noexcept
+      {
+        return snapshotHeaderSize + index * snapshotEntrySize;
+      }
+
+      const char* _data;
+      std::size_t _entryCount;
+      std::size_t _stringsOffset;
+      std::size_t _stringsSize;
+    };
+
+    // Writes a snapshot of `configuration` to `stream`; all of its properties must be valid
+    inline void writeSnapshot(const Configuration& configuration, std::ostream& stream)
+    {
+      std::vector<std::pair<std::string, const Property*>> properties;
+      std::string path;
+
+      auto visitor = [&properties](const std::string& propertyPath, const Property& property)
+        {
+          if (!property.isValid())
+            throw std::runtime_error("Cannot snapshot `" + propertyPath + "` because its value is invalid");
+
+          properties.emplace_back(propertyPath, &property);
+        };
+
+      visitSnapshotProperties(configuration, path, visitor);
+      std::sort(properties.begin(), properties.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+      std::string entries;
+      std::string strings;
+
+      auto append = [](std::string& buffer, auto value)
+        {
+          buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+
+      auto appendString = [&strings](std::string_view text)
+        {
+          if (strings.size() + text.size() > std::numeric_limits<std::uint32_t>::max())
+            throw std::runtime_error("Cannot snapshot a configuration of more than 4 GiB of strings");
+
+          auto offset = static_cast<std::uint32_t>(strings.size());
+          strings.append(text);
+          return offset;
+        };
+
+      for (auto& [propertyPath, property] : properties)
+      {
+        append(entries, appendString(propertyPath));
+        append(entries, static_cast<std::uint32_t>(propertyPath.size()));
+        append(entries, static_cast<std::uint32_t>(property->getValueId()));
+
+        switch (property->getValueId())
+        {
+        case ValueId::integer:
+          append(entries, std::uint32_t{ 0 });
+          append(entries, static_cast<std::int64_t>(property->getValueUnchecked<IntegerType>()));
+          break;
+        case ValueId::real:
+          append(entries, std::uint32_t{ 0 });
+          append(entries, property->getValueUnchecked<RealType>());
+          break;
+        case ValueId::string:
+        {
+          const StringType& value = property->getValueUnchecked<StringType>();
+          append(entries, static_cast<std::uint32_t>(value.size()));
+          append(entries, static_cast<std::uint64_t>(appendString(value)));
+          break;
+        }
+        default:
+          throw std::runtime_error("Not implemented");
+        }
+      }
+
+      if (snapshotHeaderSize + entries.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::runtime_error("Cannot snapshot a configuration of more than 4 GiB of entries");
+
+      std::string header(snapshotMagic, sizeof(snapshotMagic));
+      append(header, snapshotVersion);
+      append(header, snapshotByteOrder);
+      append(header, computeSchemaDigest(configuration));
+      append(header, static_cast<std::uint32_t>(properties.size()));
+      append(header, static_cast<std::uint32_t>(snapshotHeaderSize + entries.size()));
+      append(header, static_cast<std::uint32_t>(strings.size()));
+      append(header, std::uint32_t{ 0 });
+
+      stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+      stream.write(entries.data(), static_cast<std::streamsize>(entries.size()));
+      stream.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+      if (!stream)
+        throw std::runtime_error("Cannot write configuration snapshot");
+    }
+
+    // Loads all properties of `configuration` from `snapshot`, without parsing any text. Values are checked
+    // against their constraints only if the schema digest of `configuration` differs from that recorded in the
+    // snapshot (or either has none). Nothing is modified if a value is missing, of a wrong type or invalid. Supersedes
+    // groups deferred by `Configuration::loadLazy` without loading them, and notifies the attached dispatcher.
+    inline void loadSnapshot(Configuration& configuration, const SnapshotView& snapshot)
+    {
+      // The schema digest is computed by the same pass that reads the values
+      Digest digest;
+      bool isComplete = true;
+      std::vector<std::pair<Property*, ValueModel>> values;
+      std::string path;
+
+      auto visitor = [&](const std::string& propertyPath, const Property& property)
+        {
+          std::uint64_t constraintDigest = property.getConstraint().getDigest();
+          isComplete = isComplete && constraintDigest != 0;
+
+          digest.add(propertyPath);
+          digest.add(property.getValueId());
+          digest.add(constraintDigest);
+
+          std::optional<SnapshotView::Entry> entry = snapshot.find(propertyPath);
+
+          if (!entry)
+            throw std::runtime_error("Expected `" + propertyPath + "` to contain a value");
+
+          if (entry->getValueId() != property.getValueId())
+          {
+            throw std::runtime_error("Expected `" + propertyPath + "` to contain a value of type `"
+              + valueNameFromValueId(property.getValueId()) + '`');
+          }
+
+          // `configuration` is not const; the traversal is shared with the const users
+          values.emplace_back(const_cast<Property*>(&property), entry->toValueModel());
+        };
+
+      visitSnapshotProperties(configuration, path, visitor, false);
+
+      if (!isComplete || digest.get() != snapshot.getSchemaDigest())
+      {
+        auto invalid = std::find_if(values.cbegin(), values.cend(),
+          [](const auto& value) { return !value.first->accepts(value.second); });
+
+        if (invalid != values.cend())
+        {
+          // Paths are not kept by the pass above, so that the common case does not allocate them
+          std::size_t index = 0;
+          std::size_t invalidIndex = static_cast<std::size_t>(invalid - values.cbegin());
+
+          auto finder = [&](const std::string& propertyPath, const Property&)
+            {
+              if (index++ == invalidIndex)
+                throw std::runtime_error("Value of `" + propertyPath + "` is invalid");
+            };
+
+          visitSnapshotProperties(configuration, path, finder, false);
+        }
+      }
+
+      for (auto& [property, value] : values)
+        property->setValueModelUnchecked(std::move(value));
+
+      configuration.discardLazyGroups();
+      configuration.notifyReloaded();
+    }
+
+#ifdef SAFECONFIG_HAS_MMAP
+    // A snapshot file mapped into memory; reads through `getView()` are served straight from the mapping
+    class MappedSnapshot
+    {
+    public:
+      explicit MappedSnapshot(const std::string& fileName)
+        : _mapping(fileName)
+        , _view(_mapping.data, _mapping.size)
+      {
+      }
+
+      MappedSnapshot(const MappedSnapshot&) = delete;
+      MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+      const SnapshotView& getView() const noexcept
+      {
+        return _view;
+      }
+
+    private:
+      struct Mapping
+      {
+        explicit Mapping(const std::string& fileName)
+        {
+          int fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+          if (fd < 0)
+            throwError(fileName);
+
+          struct stat status;
+
+          if (::fstat(fd, &status) != 0)
+          {
+            int error = errno;
+            ::close(fd);
+            errno = error;
+            throwError(fileName);
+          }
+
+          // An empty file cannot be mapped, and leaves no `errno` to report
+          if (status.st_size <= 0)
+          {
+            ::close(fd);
+            throw std::runtime_error("Cannot map configuration snapshot \"" + fileName + "\" because it is empty");
+          }
+
+          size = static_cast<std::size_t>(status.st_size);
+          data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+          ::close(fd);
+
+          if (data == MAP_FAILED)
+            throwError(fileName);
+        }
+
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        ~Mapping()
+        {
+          ::munmap(data, size);
+        }
+
+        [[noreturn]] static void throwError(const std::string& fileName)
+        {
+          throw std::runtime_error("Cannot map configuration snapshot \"" + fileName + "\": " + std::strerror(errno));
+        }
+
+        void* data = nullptr;
+        std::size_t size = 0;
+      };
+
+      Mapping _mapping;
+      SnapshotView _view;
+    };
+#endif
+  }
+}
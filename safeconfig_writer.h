@@ -0,0 +1,407 @@
+#pragma once
+
+#include "safeconfig.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace safeconfig
+{
+  // A write-only `JsonLike` that emits compact json text as values are assigned, without building a tree.
+  // The writer is the root value; `operator[]` returns cursors to members, which are stored inline in the
+  // returned `JsonProxy`. Keys and values are written in the order of assignment, so a member has to be
+  // written (depth first) before the next sibling is opened, as `Group::operator>>` does. A member that
+  // is opened but never assigned is written as null. Output is completed by `finish()` or the destructor.
+  class JsonTextWriter : public JsonLike
+  {
+  public:
+    // Appends to `stream`
+    explicit JsonTextWriter(std::ostream& stream)
+      : _sink(&stream)
+      , _write(&writeToStream)
+    {
+      init();
+    }
+
+    // Appends to `buffer`
+    explicit JsonTextWriter(std::string& buffer)
+      : _sink(&buffer)
+      , _write(&writeToString)
+    {
+      init();
+    }
+
+    JsonTextWriter(const JsonTextWriter&) = delete;
+    JsonTextWriter& operator=(const JsonTextWriter&) = delete;
+
+    ~JsonTextWriter()
+    {
+      try
+      {
+        finish();
+      }
+      catch (...)
+      {
+        // The sink failed; nothing sensible left to do
+      }
+    }
+
+    // Closes all open objects; writes null if nothing has been written
+    void finish()
+    {
+      if (_isFinished)
+        return;
+
+      close(0);
+
+      if (_levels[0].isObject)
+        write('}');
+      else if (!_levels[0].isWritten)
+        write("null");
+
+      _isFinished = true;
+    }
+
+    JsonProxy operator[](const std::string& key) const override
+    {
+      return const_cast<JsonTextWriter*>(this)->openMember(0, 0, key);
+    }
+
+    bool isEmpty() const override
+    {
+      return !_levels[0].isWritten;
+    }
+
+    // Nothing written can be read back
+    bool holds(ValueId id) const override
+    {
+      static_cast<void>(id);
+      return false;
+    }
+
+    operator RealType() const override
+    {
+      throwWriteOnly();
+    }
+
+    operator StringType() const override
+    {
+      throwWriteOnly();
+    }
+
+    operator IntegerType() const override
+    {
+      throwWriteOnly();
+    }
+
+    void operator=(const RealType& value) override
+    {
+      writeValue(0, 0, value);
+    }
+
+    void operator=(const StringType& value) override
+    {
+      writeValue(0, 0, value);
+    }
+
+    void operator=(const IntegerType& value) override
+    {
+      writeValue(0, 0, value);
+    }
+
+  private:
+    // A member at `depth`, valid for as long as no sibling has been opened after it
+    class Cursor : public JsonLike
+    {
+    public:
+      Cursor(JsonTextWriter& writer, std::uint32_t depth, std::uint32_t serial)
+        : _writer(&writer)
+        , _depth(depth)
+        , _serial(serial)
+      {
+      }
+
+      JsonProxy operator[](const std::string& key) const override
+      {
+        return _writer->openMember(_depth, _serial, key);
+      }
+
+      bool isEmpty() const override
+      {
+        return !_writer->isCurrent(_depth, _serial) || !_writer->_levels[_depth].isWritten;
+      }
+
+      bool holds(ValueId id) const override
+      {
+        static_cast<void>(id);
+        return false;
+      }
+
+      operator RealType() const override
+      {
+        throwWriteOnly();
+      }
+
+      operator StringType() const override
+      {
+        throwWriteOnly();
+      }
+
+      operator IntegerType() const override
+      {
+        throwWriteOnly();
+      }
+
+      void operator=(const RealType& value) override
+      {
+        _writer->writeValue(_depth, _serial, value);
+      }
+
+      void operator=(const StringType& value) override
+      {
+        _writer->writeValue(_depth, _serial, value);
+      }
+
+      void operator=(const IntegerType& value) override
+      {
+        _writer->writeValue(_depth, _serial, value);
+      }
+
+    private:
+      JsonTextWriter* _writer;
+      std::uint32_t _depth;
+      std::uint32_t _serial;
+    };
+
+    // The state of the value at a given depth
+    struct Level
+    {
+      std::uint32_t serial = 0;
+      bool isWritten = false;
+      bool isObject = false;
+      bool hasMembers = false;
+    };
+
+    [[noreturn]] static void throwWriteOnly()
+    {
+      throw std::runtime_error("`JsonTextWriter` is write-only");
+    }
+
+    static void writeToStream(void* sink, const char* data, std::size_t size)
+    {
+      static_cast<std::ostream*>(sink)->write(data, static_cast<std::streamsize>(size));
+    }
+
+    static void writeToString(void* sink, const char* data, std::size_t size)
+    {
+      static_cast<std::string*>(sink)->append(data, size);
+    }
+
+    void init()
+    {
+      _levels.reserve(8);
+      _levels.emplace_back();
+    }
+
+    void write(const char* data, std::size_t size)
+    {
+      _write(_sink, data, size);
+    }
+
+    void write(std::string_view text)
+    {
+      write(text.data(), text.size());
+    }
+
+    void write(char c)
+    {
+      write(&c, 1);
+    }
+
+    bool isCurrent(std::uint32_t depth, std::uint32_t serial) const noexcept
+    {
+      return depth < _levels.size() && _levels[depth].serial == serial;
+    }
+
+    void assertCurrent(std::uint32_t depth, std::uint32_t serial) const
+    {
+      if (_isFinished)
+        throw std::runtime_error("Cannot write json after `JsonTextWriter::finish()`");
+
+      if (!isCurrent(depth, serial))
+        throw std::runtime_error("Cannot write json out of order; a member was superseded by a sibling");
+    }
+
+    // Completes all values deeper than `depth`
+    void close(std::uint32_t depth)
+    {
+      while (_levels.size() > depth + 1)
+      {
+        Level& level = _levels.back();
+
+        if (level.isObject)
+          write('}');
+        else if (!level.isWritten)
+          write("null");
+
+        // Keep the serial so that stale cursors into this depth are detected
+        std::uint32_t serial = level.serial;
+        _levels.pop_back();
+        _closedSerials.resize(std::max(_closedSerials.size(), _levels.size() + 1));
+        _closedSerials[_levels.size()] = serial;
+      }
+    }
+
+    JsonProxy openMember(std::uint32_t depth, std::uint32_t serial, const std::string& key)
+    {
+      assertCurrent(depth, serial);
+      close(depth);
+
+      Level& level = _levels[depth];
+
+      if (!level.isObject)
+      {
+        if (level.isWritten)
+          throw std::runtime_error("Cannot write member `" + key + "` into a json value that is not an object");
+
+        write('{');
+        level.isObject = true;
+        level.isWritten = true;
+      }
+
+      if (level.hasMembers)
+        write(',');
+
+      level.hasMembers = true;
+      writeString(key);
+      write(':');
+
+      std::uint32_t memberDepth = depth + 1;
+      std::uint32_t memberSerial = memberDepth < _closedSerials.size() ? _closedSerials[memberDepth] + 1 : 0;
+
+      _levels.emplace_back();
+      _levels.back().serial = memberSerial;
+
+      return { std::in_place_type<Cursor>, *this, memberDepth, memberSerial };
+    }
+
+    template<class T>
+    void writeValue(std::uint32_t depth, std::uint32_t serial, const T& value)
+    {
+      assertCurrent(depth, serial);
+
+      Level& level = _levels[depth];
+
+      if (level.isWritten)
+        throw std::runtime_error("Cannot write a json value twice");
+
+      close(depth);
+
+      if constexpr (std::is_same_v<T, StringType>)
+        writeString(value);
+      else
+        writeNumber(value);
+
+      level.isWritten = true;
+    }
+
+    void writeNumber(IntegerType value)
+    {
+      char buffer[std::numeric_limits<IntegerType>::digits10 + 3];
+      auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+      write(buffer, static_cast<std::size_t>(result.ptr - buffer));
+    }
+
+    void writeNumber(RealType value)
+    {
+      // Json has no representation of non-finite numbers
+      if (!std::isfinite(value))
+      {
+        write("null");
+        return;
+      }
+
+      char buffer[32];
+      auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+      std::string_view text(buffer, static_cast<std::size_t>(result.ptr - buffer));
+      write(text);
+
+      // Keep whole numbers recognisable as reals when read back
+      if (text.find_first_of(".eE") == std::string_view::npos)
+        write(".0");
+    }
+
+    void writeString(std::string_view value)
+    {
+      static constexpr char hexDigits[] = "0123456789abcdef";
+
+      write('"');
+
+      std::size_t begin = 0;
+
+      for (std::size_t i = 0; i < value.size(); ++i)
+      {
+        auto c = static_cast<unsigned char>(value[i]);
+
+        if (c >= 0x20 && c != '"' && c != '\\')
+          continue;
+
+        write(value.data() + begin, i - begin);
+        begin = i + 1;
+
+        switch (c)
+        {
+        case '"':
+          write("\\\"");
+          break;
+        case '\\':
+          write("\\\\");
+          break;
+        case '\b':
+          write("\\b");
+          break;
+        case '\f':
+          write("\\f");
+          break;
+        case '\n':
+          write("\\n");
+          break;
+        case '\r':
+          write("\\r");
+          break;
+        case '\t':
+          write("\\t");
+          break;
+        default:
+        {
+          char escaped[] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xf] };
+          write(escaped, sizeof(escaped));
+        }
+        }
+      }
+
+      write(value.data() + begin, value.size() - begin);
+      write('"');
+    }
+
+    void* _sink;
+    void (*_write)(void* sink, const char* data, std::size_t size);
+
+    // The values currently open, from the root down
+    std::vector<Level> _levels;
+
+    // The serial of the last member closed at each depth
+    std::vector<std::uint32_t> _closedSerials;
+
+    bool _isFinished = false;
+  };
+}